@@ -0,0 +1,47 @@
+/*
+ * Minimal std::allocator replacement that aligns allocations (by default, to
+ * a cache line), for dense per-element counter arrays that get hammered on
+ * the hot path.
+ */
+#pragma once
+
+#include <new>
+#include <stddef.h>
+#include <stdlib.h>
+
+template <typename T, size_t ALIGNMENT = 64>
+class AlignedAllocator {
+    public:
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind {
+            typedef AlignedAllocator<U, ALIGNMENT> other;
+        };
+
+        AlignedAllocator() {}
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, ALIGNMENT> &) {}
+
+        T *allocate(size_t n) {
+            void *p = nullptr;
+            if (posix_memalign(&p, ALIGNMENT, n * sizeof(T)) != 0) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(p);
+        }
+
+        void deallocate(T *p, size_t) {
+            free(p);
+        }
+};
+
+template <typename T, typename U, size_t A>
+bool operator==(const AlignedAllocator<T, A> &, const AlignedAllocator<U, A> &) {
+    return true;
+}
+
+template <typename T, typename U, size_t A>
+bool operator!=(const AlignedAllocator<T, A> &, const AlignedAllocator<U, A> &) {
+    return false;
+}
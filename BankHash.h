@@ -0,0 +1,109 @@
+/*
+ * Bank-selection hash functions for banked caches.
+ *
+ * Sets are indexed by the line address LSBs, while banks are selected by
+ * hashing the whole line address (see the comment in LRUSimpleCache::access()).
+ * Every hash below reduces to a bank index without a hardware divide, so the
+ * choice of hash is purely about load balance across banks.
+ *
+ * NOTE: the hash is selected with a switch rather than a virtual call, for
+ * the same reason given at the top of Cache.h.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+typedef enum {
+    BANK_HASH_FOLD,             // XOR-fold 4x16b chunks, then mod nBanks
+    BANK_HASH_FOLD_MASK,        // XOR-fold, then mask (nBanks must be 2^k)
+    BANK_HASH_CRC32C,           // CRC32C (SSE4.2 crc32 instr. when available)
+    BANK_HASH_MULTIPLICATIVE,   // Fibonacci (golden-ratio) hashing
+    BANK_HASH_PAGE_INTERLEAVED, // consecutive pages go to consecutive banks
+} bank_hash_t;
+
+class BankHasher {
+    public:
+        BankHasher(bank_hash_t type, size_t nBanks, size_t cacheLineSizeLog2,
+                size_t pageNBytes = 4096);
+        inline uint32_t hash(uint64_t lineAddr) const;
+        bank_hash_t getType() const;
+        static const char *name(bank_hash_t type);
+
+    private:
+        bank_hash_t type;
+        uint32_t nBanks;
+        uint32_t mask;          // nBanks-1, if nBanks is a power of 2
+        bool isPow2;
+        uint64_t fastModM;      // see reduce()
+        uint32_t pageShift;     // line address => page number
+
+        inline uint32_t reduce(uint32_t x) const;
+        inline uint32_t range(uint32_t x) const;
+        static inline uint32_t fold(uint64_t lineAddr);
+        static inline uint32_t crc32c(uint64_t lineAddr);
+        static const uint32_t crc32cTable[256];
+};
+
+
+/*
+ * x mod nBanks, without a divide. For non-power-of-2 bank counts this is
+ * Lemire's "fastmod" (exact for all 32-bit x), which keeps results identical
+ * to the original `% maxSize`.
+ */
+inline uint32_t BankHasher::reduce(uint32_t x) const {
+    if (isPow2) return x & mask;
+    uint64_t lowBits = fastModM * x;
+    return (uint32_t) (((__uint128_t) lowBits * nBanks) >> 64);
+}
+
+/*
+ * Maps a well-mixed 32-bit hash onto [0, nBanks) using its high bits. Only
+ * used for the hashes whose entropy lives in the high bits.
+ */
+inline uint32_t BankHasher::range(uint32_t x) const {
+    return (uint32_t) (((uint64_t) x * nBanks) >> 32);
+}
+
+inline uint32_t BankHasher::fold(uint64_t lineAddr) {
+    uint32_t res = 0;
+    uint64_t tmp = lineAddr;
+    for (uint32_t i = 0; i < 4; i++) {
+        res ^= (uint32_t) ( ((uint64_t)0xffff) & tmp);
+        tmp = tmp >> 16;
+    }
+    return res;
+}
+
+inline uint32_t BankHasher::crc32c(uint64_t lineAddr) {
+#if defined(__SSE4_2__)
+    return (uint32_t) _mm_crc32_u64(0xffffffff, lineAddr);
+#else
+    // table-driven fallback; produces the same values as the instruction
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < 8; i++) {
+        crc = crc32cTable[(crc ^ lineAddr) & 0xff] ^ (crc >> 8);
+        lineAddr >>= 8;
+    }
+    return crc;
+#endif
+}
+
+inline uint32_t BankHasher::hash(uint64_t lineAddr) const {
+    switch (type) {
+        case BANK_HASH_FOLD:
+        case BANK_HASH_FOLD_MASK:
+            return reduce(fold(lineAddr));
+        case BANK_HASH_CRC32C:
+            return range(crc32c(lineAddr));
+        case BANK_HASH_MULTIPLICATIVE:
+            return range((uint32_t) ((lineAddr * 0x9e3779b97f4a7c15ULL) >> 32));
+        case BANK_HASH_PAGE_INTERLEAVED:
+            // note: page numbers are taken mod 2^32 before the bank reduction
+            return reduce((uint32_t) (lineAddr >> pageShift));
+    }
+    return 0;
+}
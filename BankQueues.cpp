@@ -0,0 +1,86 @@
+/*
+ * Implementation of the bank contention model (see BankQueues.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "BankQueues.h"
+
+
+BankQueues::BankQueues(size_t nBanks, uint32_t serviceCycles) {
+    assert(nBanks > 0 and serviceCycles > 0);
+    this->serviceCycles = serviceCycles;
+    busyUntil = std::vector<uint64_t>(nBanks, 0);
+    busyCycles = std::vector<uint64_t>(nBanks, 0);
+    nConflicts = std::vector<uint64_t>(nBanks, 0);
+    delays = std::vector<Histogram>(nBanks);
+    clearStats();
+}
+
+/*
+ * Zeroes the counters, leaving accesses still in service alone.
+ */
+void BankQueues::clearStats() {
+    std::fill(busyCycles.begin(), busyCycles.end(), 0);
+    std::fill(nConflicts.begin(), nConflicts.end(), 0);
+    for (Histogram &h : delays) h.clear();
+    firstArrival = UINT64_MAX;
+    lastDone = 0;
+}
+
+size_t BankQueues::getNBanks() const {
+    return busyUntil.size();
+}
+
+uint32_t BankQueues::getServiceCycles() const {
+    return serviceCycles;
+}
+
+uint64_t BankQueues::getNConflicts(size_t bank) const {
+    return nConflicts[bank];
+}
+
+/*
+ * Queueing delay summed over every access to every bank.
+ */
+uint64_t BankQueues::getTotalDelay() const {
+    uint64_t total = 0;
+    for (const Histogram &h : delays) total += h.getSum();
+    return total;
+}
+
+/*
+ * Fraction of the time from the first arrival until the last access was
+ * served that bank was busy.
+ */
+double BankQueues::getUtilization(size_t bank) const {
+    if (lastDone <= firstArrival) return 0.0;
+    return double(busyCycles[bank]) / double(lastDone - firstArrival);
+}
+
+const Histogram &BankQueues::getQueueingDelays(size_t bank) const {
+    return delays[bank];
+}
+
+/*
+ * Queueing delays across all banks.
+ */
+Histogram BankQueues::getQueueingDelays() const {
+    Histogram all;
+    for (const Histogram &h : delays) all.merge(h);
+    return all;
+}
+
+void BankQueues::dumpText(FILE * const f, const char * const prefix) const {
+    for (size_t b = 0; b < busyUntil.size(); ++b) {
+        const Histogram &h = delays[b];
+        fprintf(f, "%s%zu\tutil: %.2f%%  conflicts: %zu  wait mean: %.2f  "
+                "p99: %zu  max: %zu\n", prefix, b, getUtilization(b) * 100,
+                (size_t) nConflicts[b], h.getMean(),
+                (size_t) h.percentile(99), (size_t) h.getMax());
+    }
+}
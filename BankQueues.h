@@ -0,0 +1,64 @@
+/*
+ * Contention model for the banks of a banked cache.
+ *
+ * Each bank serves one access at a time, taking serviceCycles; an access
+ * that arrives while its bank is still busy queues behind the ones ahead of
+ * it (FIFO). Arrival times are supplied by the caller, so this only needs to
+ * remember when each bank next goes idle.
+ *
+ * Kept per bank: busy cycles (for utilization), conflicts (accesses that had
+ * to wait), and the distribution of queueing delays.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "Histogram.h"
+
+class BankQueues {
+    public:
+        BankQueues(size_t nBanks, uint32_t serviceCycles);
+        inline uint64_t arrive(size_t bank, uint64_t now);
+        void clearStats();
+
+        size_t getNBanks() const;
+        uint32_t getServiceCycles() const;
+        uint64_t getNConflicts(size_t bank) const;
+        uint64_t getTotalDelay() const;
+        double getUtilization(size_t bank) const;
+        const Histogram &getQueueingDelays(size_t bank) const;
+        Histogram getQueueingDelays() const;
+        void dumpText(FILE * const f, const char * const prefix) const;
+
+    private:
+        uint32_t serviceCycles;
+        std::vector<uint64_t> busyUntil;    // [bank]
+        std::vector<uint64_t> busyCycles;   // [bank]
+        std::vector<uint64_t> nConflicts;   // [bank]
+        std::vector<Histogram> delays;      // [bank]
+        uint64_t firstArrival, lastDone;    // span the utilization is over
+};
+
+
+/*
+ * Queues an access arriving at bank at cycle now.
+ *
+ * Return value: the cycles it waited before its bank started on it.
+ */
+inline uint64_t BankQueues::arrive(size_t bank, uint64_t now) {
+    uint64_t start = now;
+    if (busyUntil[bank] > now) {
+        start = busyUntil[bank];
+        ++nConflicts[bank];
+    }
+    busyUntil[bank] = start + serviceCycles;
+    busyCycles[bank] += serviceCycles;
+    delays[bank].record(start - now);
+
+    if (now < firstArrival) firstArrival = now;
+    if (busyUntil[bank] > lastDone) lastDone = busyUntil[bank];
+    return start - now;
+}
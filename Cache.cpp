@@ -1,6 +1,7 @@
 /*
  * Implementation of cache simulator module.
  */
+#include <algorithm>
 #include <assert.h>
 #include <fstream>
 #include <iostream>
@@ -12,16 +13,113 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/syscall.h>
+#include <thread>
 #include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
 #include "Cache.h"
+#include "DRAM.h"
+#include "Directory.h"
+#include "L1Filter.h"
+#include "MissTrace.h"
+#include "SPSCRing.h"
+#include "WorkStealingPool.h"
+
+
+/*
+ * Load-balance helpers shared by the banked caches below.
+ * Imbalance is (max bank accesses) / (mean bank accesses); 1.0 is perfect.
+ */
+static double computeBankImbalance(const std::vector<size_t> &bankAccesses) {
+    size_t total = 0, max = 0;
+    for (size_t n : bankAccesses) {
+        total += n;
+        if (n > max) max = n;
+    }
+    if (total == 0) return 0.0;
+
+    double mean = double(total) / double(bankAccesses.size());
+    return double(max) / mean;
+}
+
+static void dumpBankAccesses(FILE * const f, const char * const prefix,
+        const std::vector<size_t> &bankAccesses) {
+    size_t total = 0;
+    for (size_t n : bankAccesses) total += n;
+
+    for (size_t b = 0; b < bankAccesses.size(); ++b) {
+        double pct = total == 0 ? 0.0 :
+                double(bankAccesses[b]) / double(total) * 100;
+        fprintf(f, "%s%zu\t%zu (%.2f%%)\n", prefix, b, bankAccesses[b], pct);
+    }
+}
+
+
+static void dumpFootprint(FILE * const f, const char * const prefix,
+        const FootprintBitmap &footprint) {
+    fprintf(f, "%sLINES\t%zu\n", prefix, footprint.getNLinesTouched());
+    fprintf(f, "%s4KiB_PAGES\t%zu\n", prefix, footprint.footprint(4096));
+    fprintf(f, "%s2MiB_PAGES\t%zu\n", prefix, footprint.footprint(1 << 21));
+}
+
+#ifdef CACHESIM_SET_STATS
+/*
+ * Set-stats helpers shared by the banked caches below.
+ *
+ * Heatmap file format (all little-endian), one section per cache level:
+ *   char[4]  magic ("CSSH")
+ *   uint32_t version (1)
+ *   uint64_t nBanks, nSetsPerBank
+ *   nBanks*nSetsPerBank x { uint64_t hits, misses, evictions } (bank-major)
+ */
+static void writeSetStatsHeatmap(std::ofstream &of, size_t nBanks,
+        size_t nSetsPerBank, const std::vector<set_stats_t> &setStats) {
+    const char magic[4] = { 'C', 'S', 'S', 'H' };
+    uint32_t version = 1;
+    uint64_t dims[2] = { nBanks, nSetsPerBank };
+
+    of.write(magic, sizeof(magic));
+    of.write((char *)&version, sizeof(version));
+    of.write((char *)dims, sizeof(dims));
+    of.write((char *)setStats.data(), setStats.size() * sizeof(set_stats_t));
+}
+
+static void dumpTextSetStats(FILE * const f, const char * const prefix,
+        size_t nBanks, size_t nSetsPerBank,
+        const std::vector<set_stats_t> &setStats) {
+    size_t hottestSet = 0;
+    uint64_t hottestSetMisses = 0;
+
+    for (size_t b = 0; b < nBanks; ++b) {
+        set_stats_t bank = { 0, 0, 0 };
+        for (size_t set = 0; set < nSetsPerBank; ++set) {
+            const set_stats_t &ss = setStats[b * nSetsPerBank + set];
+            bank.hits += ss.hits;
+            bank.misses += ss.misses;
+            bank.evictions += ss.evictions;
+            if (ss.misses > hottestSetMisses) {
+                hottestSetMisses = ss.misses;
+                hottestSet = b * nSetsPerBank + set;
+            }
+        }
+        fprintf(f, "%s%zu\tH: %zu  M: %zu  E: %zu\n", prefix, b,
+                (size_t) bank.hits, (size_t) bank.misses,
+                (size_t) bank.evictions);
+    }
+
+    fprintf(f, "%sMOST_MISSED_SET\tbank %zu set %zu (%zu misses)\n", prefix,
+            hottestSet / nSetsPerBank, hottestSet % nSetsPerBank,
+            (size_t) hottestSetMisses);
+}
+#endif
 
 
 /* Base class definitions */
 SimpleCache::SimpleCache(size_t nLines, size_t nWays, size_t nBanks,
-        size_t cacheLineNBytes, bool allocateOnWritesOnly) {
+        size_t cacheLineNBytes, bool allocateOnWritesOnly,
+        bank_hash_t bankHash) :
+        bankHasher(bankHash, nBanks, log2(cacheLineNBytes)) {
     this->nLines = nLines;
     this->nWays = nWays;
     assert(nLines % nWays == 0);
@@ -34,16 +132,27 @@ SimpleCache::SimpleCache(size_t nLines, size_t nWays, size_t nBanks,
 
     this->cacheLineSizeLog2 = log2(cacheLineNBytes);
     this->allocateOnWritesOnly = allocateOnWritesOnly;
-}
 
-inline uint32_t SimpleCache::fastHash(line_addr_t lineAddr, uint64_t maxSize) {
-    uint32_t res = 0;
-    uint64_t tmp = lineAddr;
-    for (uint32_t i = 0; i < 4; i++) {
-        res ^= (uint32_t) ( ((uint64_t)0xffff) & tmp);
-        tmp = tmp >> 16;
-    }
-    return (res % maxSize);
+    this->bankAccesses = std::vector<size_t>(nBanks, 0);
+    this->nAccesses = 0;
+#ifdef CACHESIM_SET_STATS
+    this->setStats = std::vector<set_stats_t>(nBanks * nSetsPerBank);
+#endif
+
+    this->timingEnabled = false;
+    this->hitLatency = 0;
+    this->memLatency = 0;
+
+    this->network = nullptr;
+    this->homeMap = nullptr;
+    this->requestNBytes = 0;
+    this->directory = nullptr;
+    this->directoryNode = -1;
+    this->bankClock = nullptr;
+    this->dram = nullptr;
+    this->missTrace = nullptr;
+    this->forwardsMisses = false;
+    this->curTimestamp = 0;
 }
 
 inline line_addr_t SimpleCache::addrToLineAddr(intptr_t addr) {
@@ -77,6 +186,43 @@ uint64_t SimpleCache::getCacheLineSizeLog2() {
 }
 
 void SimpleCache::computeStats() {
+    computeRatios(s);
+    s.bankImbalance = computeBankImbalance(bankAccesses);
+
+    // every access costs one of two latencies, so the counters say it all
+    if (timingEnabled) {
+        accessLatencies.clear();
+        accessLatencies.record(hitLatency, s.nH);
+        accessLatencies.record(hitLatency + memLatency, s.nM);
+        s.totalCycles = accessLatencies.getSum();
+        s.stallCycles = s.totalCycles - (s.nH + s.nM) * hitLatency;
+        s.AMAT = accessLatencies.getMean();
+    }
+
+    if (bankQueues) {
+        s.bankConflicts = 0;
+        for (size_t b = 0; b < nBanks; ++b) {
+            s.bankConflicts += bankQueues->getNConflicts(b);
+        }
+        s.bankQueueingCycles = bankQueues->getTotalDelay();
+
+        // waiting for a bank stalls the access (on top of the above)
+        if (timingEnabled) {
+            s.totalCycles += s.bankQueueingCycles;
+            s.stallCycles += s.bankQueueingCycles;
+            s.AMAT = s.nH + s.nM == 0 ? 0.0 :
+                    double(s.totalCycles) / double(s.nH + s.nM);
+        }
+    }
+
+    s.computedFinalStats = true;
+}
+
+/*
+ * Fills in the totals and percentages of s from its raw counters. Static, so
+ * that stats summed across caches (or ranks) can be finalized too.
+ */
+void SimpleCache::computeRatios(stats_t &s) {
     s.nR = s.RH + s.RM;
     s.nW = s.WH + s.WM;
 
@@ -95,14 +241,159 @@ void SimpleCache::computeStats() {
     if (s.nM != 0) {
         s.EP = double(s.nE) / double(s.nM);
     }
-
-    s.computedFinalStats = true;
 }
 
 SimpleCache::stats_t *SimpleCache::getStats() {
     return &s;
 }
 
+/*
+ * Whether anything beyond the plain hit/miss simulation is enabled or
+ * attached, i.e., whether the stats depend on more than the constructor's
+ * parameters.
+ */
+bool SimpleCache::hasOptionalModels() {
+    return classifier != nullptr or timingEnabled or network != nullptr or
+            directory != nullptr or bankQueues != nullptr or forwardsMisses;
+}
+
+const std::vector<size_t> &SimpleCache::getBankAccesses() {
+    return bankAccesses;
+}
+
+/*
+ * Returns a pointer to the count of accesses made so far, e.g., for use as a
+ * Network window clock.
+ */
+const uint64_t *SimpleCache::getAccessCounter() {
+    return &nAccesses;
+}
+
+/*
+ * Starts splitting read/write misses into compulsory, capacity, and conflict
+ * misses. Should be called before the first access, since the classifier only
+ * knows about lines it has seen.
+ */
+void SimpleCache::enableMissClassification() {
+    classifier.reset(new MissClassifier(nLines, cacheLineSizeLog2));
+}
+
+/*
+ * Starts estimating time: a hit takes hitLatency cycles, and a miss another
+ * memLatency on top. Stall cycles are those beyond hitLatency.
+ */
+void SimpleCache::setLatencies(uint32_t hitLatency, uint32_t memLatency) {
+    this->timingEnabled = true;
+    this->hitLatency = hitLatency;
+    this->memLatency = memLatency;
+}
+
+/*
+ * Per-access latency distribution (as of the last computeStats()).
+ */
+const Histogram &SimpleCache::getAccessLatencies() {
+    return accessLatencies;
+}
+
+/*
+ * Models distributed shared memory: from now on, every miss on a line whose
+ * home (per homeMap) isn't network's rank sends a requestNBytes request to
+ * the home, and receives a line from it. Lines written while cached are
+ * dirty, and are written back (a line sent to the home) when evicted.
+ * Messages are sent at the access's timestamp (see access()).
+ */
+void SimpleCache::attachNetwork(Network *network, const HomeMap *homeMap,
+        size_t requestNBytes) {
+    this->network = network;
+    this->homeMap = homeMap;
+    this->requestNBytes = requestNBytes;
+    dirtyRemoteLines.clear();
+}
+
+void SimpleCache::remoteAccess(line_addr_t line, bool isWrite, bool wasHit) {
+    int home = homeMap->home(line << cacheLineSizeLog2);
+    if (home == network->getOurGlobalRank()) return;
+
+    if (!wasHit) {
+        network->sendTo(home, requestNBytes, curTimestamp);
+        network->receiveFrom(home, size_t(1) << cacheLineSizeLog2);
+        ++s.remoteMisses;
+    }
+    // writes always allocate, so the line is cached (and now dirty)
+    if (isWrite) dirtyRemoteLines.insert(line);
+}
+
+void SimpleCache::remoteEviction(line_addr_t line) {
+    if (dirtyRemoteLines.erase(line) == 0) return;
+
+    int home = homeMap->home(line << cacheLineSizeLog2);
+    network->sendTo(home, size_t(1) << cacheLineSizeLog2, curTimestamp);
+    ++s.remoteWritebacks;
+}
+
+/*
+ * Reports every eviction to directory, as coming from the given node. See
+ * Directory, which attaches its nodes' caches itself.
+ */
+void SimpleCache::attachDirectory(Directory *directory, int node) {
+    this->directory = directory;
+    this->directoryNode = node;
+}
+
+/*
+ * Models each bank as a server that takes serviceCycles per access: an
+ * access arriving while its bank is busy waits for it (see BankQueues).
+ * Arrival times come from the timestamp passed to access(), or from *clock,
+ * or else are one per cycle.
+ */
+void SimpleCache::enableBankQueueing(uint32_t serviceCycles,
+        const uint64_t *clock) {
+    bankQueues.reset(new BankQueues(nBanks, serviceCycles));
+    this->bankClock = clock;
+}
+
+const BankQueues *SimpleCache::getBankQueues() {
+    return bankQueues.get();
+}
+
+/*
+ * Sends every miss to dram as a line read, and every eviction of a line
+ * written since it was cached as a line write, stamped with the access's
+ * time (see access()). Flush dram before reading its stats.
+ */
+void SimpleCache::attachDRAM(DRAM *dram) {
+    this->dram = dram;
+    if (!forwardsMisses) dirtyLines.clear();
+    forwardsMisses = dram != nullptr or missTrace != nullptr;
+}
+
+/*
+ * Streams the same misses and writebacks attachDRAM() would send to memory
+ * into missTrace, stamped with the index of the access causing each.
+ */
+void SimpleCache::setMissTrace(MissTraceWriter *missTrace) {
+    this->missTrace = missTrace;
+    if (!forwardsMisses) dirtyLines.clear();
+    forwardsMisses = dram != nullptr or missTrace != nullptr;
+}
+
+void SimpleCache::memoryAccess(line_addr_t line, bool isWrite, bool wasHit) {
+    if (!wasHit) {
+        if (dram != nullptr) dram->request(line, false, curTimestamp);
+        if (missTrace != nullptr) missTrace->record(nAccesses - 1, line, false);
+        ++s.memReads;
+    }
+    // writes always allocate, so the line is cached (and now dirty)
+    if (isWrite) dirtyLines.insert(line);
+}
+
+void SimpleCache::memoryEviction(line_addr_t line) {
+    if (dirtyLines.erase(line) == 0) return;
+    if (dram != nullptr) dram->request(line, true, curTimestamp);
+    if (missTrace != nullptr) missTrace->record(nAccesses - 1, line, true);
+    ++s.memWritebacks;
+}
+
 /*
  * Used for terminating the warmup phase. Zeroes stats counters while leaving
  * the maps and lists that actually store the accessed locations intact.
@@ -110,6 +401,11 @@ SimpleCache::stats_t *SimpleCache::getStats() {
 void SimpleCache::zeroStatsCounters() {
     memset(&s, 0, sizeof(s));
     misses.clear();
+    std::fill(bankAccesses.begin(), bankAccesses.end(), 0);
+    if (bankQueues) bankQueues->clearStats();
+#ifdef CACHESIM_SET_STATS
+    std::fill(setStats.begin(), setStats.end(), set_stats_t());
+#endif
 }
 
 void SimpleCache::dumpTextStats(FILE * const f) {
@@ -126,6 +422,47 @@ void SimpleCache::dumpTextStats(FILE * const f) {
     fprintf(f, "WRITE_MISSES\t%zu (%.2f%%)\n", s.WM, s.WMP*100);
     fprintf(f, "EVICTIONS\t%zu (%.2f%%)\n", s.nE, s.EP*100);
 
+    if (nBanks > 1) {
+        fprintf(f, "BANK_HASH\t%s\n", BankHasher::name(bankHasher.getType()));
+        fprintf(f, "BANK_IMBALANCE\t%.3f (max/mean)\n", s.bankImbalance);
+        dumpBankAccesses(f, "BANK_", bankAccesses);
+    }
+    if (bankQueues) {
+        fprintf(f, "BANK_SERVICE_CYCLES\t%u\n",
+                bankQueues->getServiceCycles());
+        fprintf(f, "BANK_CONFLICTS\t%zu\n", s.bankConflicts);
+        fprintf(f, "BANK_QUEUEING_CYCLES\t%zu\n", s.bankQueueingCycles);
+        bankQueues->dumpText(f, "BANK_QUEUE_");
+    }
+#ifdef CACHESIM_SET_STATS
+    dumpTextSetStats(f, "SETSTATS_BANK_", nBanks, nSetsPerBank, setStats);
+#endif
+
+    if (classifier) {
+        for (int c = 0; c < N_MISS_CLASSES; ++c) {
+            const char *name = MissClassifier::name(miss_class_t(c));
+            fprintf(f, "READ_MISSES_%s\t%zu\n", name, s.RMByClass[c]);
+            fprintf(f, "WRITE_MISSES_%s\t%zu\n", name, s.WMByClass[c]);
+        }
+        dumpFootprint(f, "FOOTPRINT_", classifier->getFootprint());
+    }
+
+    if (timingEnabled) {
+        fprintf(f, "AMAT\t%.2f cycles\n", s.AMAT);
+        fprintf(f, "TOTAL_CYCLES\t%zu\n", s.totalCycles);
+        fprintf(f, "STALL_CYCLES\t%zu\n", s.stallCycles);
+    }
+
+    if (network != nullptr) {
+        fprintf(f, "HOME_MAP\t%s\n", HomeMap::name(homeMap->getKind()));
+        fprintf(f, "REMOTE_MISSES\t%zu\n", s.remoteMisses);
+        fprintf(f, "REMOTE_WRITEBACKS\t%zu\n", s.remoteWritebacks);
+    }
+
+    if (forwardsMisses) {
+        fprintf(f, "MEM_READS\t%zu\n", s.memReads);
+        fprintf(f, "MEM_WRITEBACKS\t%zu\n", s.memWritebacks);
+    }
 }
 
 void SimpleCache::dumpTextStats(const char * const outputFilepath) {
@@ -151,17 +488,43 @@ void SimpleCache::dumpBinaryStats(const char * const outputFilepath) {
     of.close();
 }
 
+/*
+ * Dumps the per-set counters as a binary heatmap (format described above
+ * writeSetStatsHeatmap()).
+ */
+void SimpleCache::dumpSetStats(const char * const outputFilepath) {
+#ifdef CACHESIM_SET_STATS
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    writeSetStatsHeatmap(of, nBanks, nSetsPerBank, setStats);
+    of.close();
+#else
+    fprintf(stderr, "Per-set stats not compiled in (need SET_STATS=1); "
+            "not writing %s\n", outputFilepath);
+#endif
+}
+
 
 /* Derived class definitions */
 LRUSimpleCache::LRUSimpleCache(size_t nLines, size_t nWays, size_t nBanks,
-        size_t cacheLineNBytes, bool allocateOnWritesOnly) : SimpleCache(
-        nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly) {
-
-    // initialize the 2-D maps + lists (to support banks)
-    maps = std::vector<std::vector<map_t>>(nBanks,
-            std::vector<map_t>(nSetsPerBank));
-    lists = std::vector<std::vector<list_t>>(nBanks,
-            std::vector<list_t>(nSetsPerBank));
+        size_t cacheLineNBytes, bool allocateOnWritesOnly,
+        bank_hash_t bankHash) : SimpleCache(nLines, nWays, nBanks,
+        cacheLineNBytes, allocateOnWritesOnly, bankHash) {
+
+    // highly-associative (e.g., fully-associative) sets get a pre-sized
+    // open-addressing index + flat LRU list each, rather than a map + list
+    if (nWays > FA_ENGINE_MIN_WAYS) {
+        faSets.reserve(nBanks * nSetsPerBank);
+        for (size_t i = 0; i < nBanks * nSetsPerBank; ++i) {
+            faSets.emplace_back(nWays);
+        }
+    }
+    else {
+        // initialize the 2-D maps + lists (to support banks)
+        maps = std::vector<std::vector<map_t>>(nBanks,
+                std::vector<map_t>(nSetsPerBank));
+        lists = std::vector<std::vector<list_t>>(nBanks,
+                std::vector<list_t>(nSetsPerBank));
+    }
 
     std::cerr << "done initializing data structures" << std::endl;
 }
@@ -197,6 +560,11 @@ bool LRUSimpleCache::touchLine(line_addr_t line, map_t &map, list_t &list,
 
         ++s.nE;     // record the eviction
         logMiss(otherToEvict, true);
+        if (network != nullptr) remoteEviction(otherToEvict);
+        if (forwardsMisses) memoryEviction(otherToEvict);
+        if (directory != nullptr) {
+            directory->evicted(directoryNode, otherToEvict);
+        }
     }
 
     // "touch" (emplace the line at back) to update it for LRU
@@ -211,26 +579,268 @@ bool LRUSimpleCache::touchLine(line_addr_t line, map_t &map, list_t &list,
     return wasInCache;
 }
 
-void LRUSimpleCache::access(uintptr_t addr, bool isWrite) {
+/*
+ * Same as above, but for a set held in the fully-associative engine.
+ */
+bool LRUSimpleCache::touchLine(line_addr_t line, FullyAssocLRU &faSet,
+        bool allocateOnWritesOnly, bool isWrite) {
+    bool shouldAllocate = !allocateOnWritesOnly or isWrite;
+
+    bool evicted;
+    uint64_t evictedLine;
+    bool wasInCache = faSet.touch(line, shouldAllocate, evicted, evictedLine);
+
+    if (evicted) {
+        ++s.nE;     // record the eviction
+        logMiss(evictedLine, true);
+        if (network != nullptr) remoteEviction(evictedLine);
+        if (forwardsMisses) memoryEviction(evictedLine);
+        if (directory != nullptr) {
+            directory->evicted(directoryNode, evictedLine);
+        }
+    }
+
+    if (!wasInCache and !isWrite) logMiss(line, false);    // log the read miss
+
+    return wasInCache;
+}
+
+bool LRUSimpleCache::containsLine(line_addr_t line) {
+    size_t set = lineToLXSet(line, nSetsPerBank);
+    size_t bank = bankHasher.hash(line);
+
+    if (!faSets.empty()) {
+        return faSets[bank * nSetsPerBank + set].contains(line);
+    }
+    return maps[bank][set].count(line) != 0;
+}
+
+/*
+ * Drops line (e.g., on a coherence invalidation), without counting it as an
+ * eviction.
+ *
+ * Return value: whether/not line was present.
+ */
+bool LRUSimpleCache::invalidateLine(line_addr_t line) {
+    size_t set = lineToLXSet(line, nSetsPerBank);
+    size_t bank = bankHasher.hash(line);
+
+    // dirty data still has to reach memory
+    if (forwardsMisses) memoryEviction(line);
+
+    if (!faSets.empty()) {
+        return faSets[bank * nSetsPerBank + set].erase(line);
+    }
+
+    auto &map = maps[bank][set];
+    auto it = map.find(line);
+    if (it == map.end()) return false;
+    lists[bank][set].erase(it->second);
+    map.erase(it);
+    return true;
+}
+
+/*
+ * Equivalent to access(addrs[i], isWrites[i]) for each i, in order.
+ */
+void LRUSimpleCache::accessBatch(const uintptr_t *addrs,
+        const uint8_t *isWrites, size_t n) {
+    for (size_t i = 0; i < n; ++i) access(addrs[i], isWrites[i]);
+}
+
+/*
+ * Equivalent to accessBatch(), but splits the trace into nChunks (default:
+ * one per pool thread) simulated in parallel.
+ *
+ * An LRU set's state is just its last nWays distinct lines, in order, so
+ * once a set has seen nWays distinct lines within a chunk, it's in the same
+ * state whatever state the chunk started from. So the first chunk runs on
+ * this cache, and every other one on a cold copy, which counts only the
+ * accesses to sets that had converged (were full). Then, chunk by chunk,
+ * this cache replays the rest (the accesses up to each set's convergence)
+ * on top of the true state, and adopts the cold copy's converged sets and
+ * counts. Results are exact; the serial part is small as long as chunks are
+ * much longer than the cache.
+ *
+ * Falls back to accessBatch() when state isn't just LRU order: with
+ * allocateOnWritesOnly (reads reorder without allocating), or any of the
+ * per-access models (miss classification, network, directory, DRAM/miss
+ * trace, bank queueing).
+ */
+void LRUSimpleCache::accessBatchParallel(const uintptr_t *addrs,
+        const uint8_t *isWrites, size_t n, WorkStealingPool &pool,
+        size_t nChunks) {
+    if (nChunks == 0) nChunks = pool.getNThreads();
+    size_t chunkN = nChunks == 0 ? n : (n + nChunks - 1) / nChunks;
+
+    bool onlyLRUState = !allocateOnWritesOnly and !classifier and
+            network == nullptr and directory == nullptr and
+            !forwardsMisses and !bankQueues;
+    if (!onlyLRUState or nChunks < 2 or chunkN < nLines) {
+        accessBatch(addrs, isWrites, n);
+        return;
+    }
+
+    std::vector<std::unique_ptr<LRUSimpleCache>> cold(nChunks);
+    std::vector<std::vector<size_t>> unconverged(nChunks);
+    pool.submit([this, addrs, isWrites, chunkN]() {
+        accessBatch(addrs, isWrites, chunkN);
+    });
+    for (size_t k = 1; k < nChunks and k * chunkN < n; ++k) {
+        size_t begin = k * chunkN, end = std::min(n, begin + chunkN);
+        pool.submit([this, addrs, isWrites, begin, end, k, &cold,
+                &unconverged]() {
+            cold[k].reset(new LRUSimpleCache(nLines, nWays, nBanks,
+                    size_t(1) << cacheLineSizeLog2, false,
+                    bankHasher.getType()));
+            cold[k]->simulateCold(addrs, isWrites, begin, end, unconverged[k]);
+        });
+    }
+    pool.wait();
+
+    for (size_t k = 1; k < nChunks and cold[k]; ++k) {
+        for (size_t i : unconverged[k]) access(addrs[i], isWrites[i]);
+        adoptConverged(*cold[k]);
+        cold[k].reset();
+    }
+}
+
+/*
+ * Runs [begin, end) of the trace on this (cold) cache, counting only the
+ * accesses to full sets. The others just update the LRU order, and are
+ * listed in unconverged.
+ */
+void LRUSimpleCache::simulateCold(const uintptr_t *addrs,
+        const uint8_t *isWrites, size_t begin, size_t end,
+        std::vector<size_t> &unconverged) {
+    for (size_t i = begin; i < end; ++i) {
+        line_addr_t line = addrToLineAddr(addrs[i]);
+        size_t set = lineToLXSet(line, nSetsPerBank);
+        size_t bank = bankHasher.hash(line);
+
+        if (!faSets.empty()) {
+            FullyAssocLRU &faSet = faSets[bank * nSetsPerBank + set];
+            if (faSet.size() == nWays) {
+                access(addrs[i], isWrites[i]);
+                continue;
+            }
+            faSet.touch(line);  // can't evict: the set isn't full
+        }
+        else {
+            map_t &map = maps[bank][set];
+            list_t &list = lists[bank][set];
+            if (map.size() == nWays) {
+                access(addrs[i], isWrites[i]);
+                continue;
+            }
+            auto it = map.find(line);
+            if (it != map.end()) {
+                list.erase(it->second);
+                map.erase(it);
+            }
+            list.emplace_back(line);
+            map.emplace(line, std::prev(list.end()));
+        }
+        unconverged.push_back(i);
+    }
+}
+
+/*
+ * Takes over cold's full sets (which match what ours would be, once we've
+ * replayed its unconverged accesses), and adds its counts to ours.
+ */
+void LRUSimpleCache::adoptConverged(LRUSimpleCache &cold) {
+    for (size_t bank = 0; bank < nBanks; ++bank) {
+        for (size_t set = 0; set < nSetsPerBank; ++set) {
+            if (!faSets.empty()) {
+                size_t i = bank * nSetsPerBank + set;
+                if (cold.faSets[i].size() == nWays) {
+                    std::swap(faSets[i], cold.faSets[i]);
+                }
+            }
+            else if (cold.maps[bank][set].size() == nWays) {
+                // swapping the lists keeps the maps' iterators valid
+                std::swap(maps[bank][set], cold.maps[bank][set]);
+                std::swap(lists[bank][set], cold.lists[bank][set]);
+            }
+        }
+        bankAccesses[bank] += cold.bankAccesses[bank];
+    }
+
+    s.RH += cold.s.RH;
+    s.RM += cold.s.RM;
+    s.WH += cold.s.WH;
+    s.WM += cold.s.WM;
+    s.nE += cold.s.nE;
+    nAccesses += cold.nAccesses;
+    for (auto &kv : cold.misses) {
+        miss_stats_t &m = misses[kv.first];
+        m.nReads += kv.second.nReads;
+        m.nWrites += kv.second.nWrites;
+    }
+#ifdef CACHESIM_SET_STATS
+    for (size_t i = 0; i < setStats.size(); ++i) {
+        setStats[i].hits += cold.setStats[i].hits;
+        setStats[i].misses += cold.setStats[i].misses;
+        setStats[i].evictions += cold.setStats[i].evictions;
+    }
+#endif
+}
+
+void LRUSimpleCache::access(uintptr_t addr, bool isWrite,
+        uint64_t timestamp) {
     line_addr_t lineAddr = addrToLineAddr(addr);
 
     // NOTE: want constant propagation w/these, may not get it
     // Why do we only take LSBs for set, but hash banks?
     // 1. Because sets are about optimizing for capacity utilization, and
-    // 2. Because banks are about optimizing for concurrency
+    // 2. Because banks are about optimizing for concurrency (which
+    //    enableBankQueueing() can check)
     size_t set = lineToLXSet(lineAddr, nSetsPerBank);
-    size_t bank = fastHash(lineAddr, nBanks);
-
-    // retrieve the correct map and list for the Way
-    auto &map = maps[bank][set];
-    auto &list = lists[bank][set];
+    size_t bank = bankHasher.hash(lineAddr);
+    ++bankAccesses[bank];
+    ++nAccesses;
+    curTimestamp = timestamp;
+    if (bankQueues) bankQueues->arrive(bank, timestamp);
+
+#ifdef CACHESIM_SET_STATS
+    size_t nEBefore = s.nE;
+#endif
+
+    bool wasHit;
+    if (!faSets.empty()) {
+        auto &faSet = faSets[bank * nSetsPerBank + set];
+        wasHit = touchLine(lineAddr, faSet, allocateOnWritesOnly, isWrite);
+    }
+    else {
+        // retrieve the correct map and list for the Way
+        auto &map = maps[bank][set];
+        auto &list = lists[bank][set];
 
-    bool wasHit = touchLine(lineAddr, map, list, nWays, allocateOnWritesOnly,
-            isWrite);
+        wasHit = touchLine(lineAddr, map, list, nWays, allocateOnWritesOnly,
+                isWrite);
+    }
 
     // record stats
     if (!isWrite) wasHit ? ++s.RH : ++s.RM;
     else          wasHit ? ++s.WH : ++s.WM;
+
+    if (classifier) {
+        bool allocate = !allocateOnWritesOnly or isWrite;
+        miss_class_t missClass = classifier->access(lineAddr, allocate);
+        if (!wasHit) {
+            isWrite ? ++s.WMByClass[missClass] : ++s.RMByClass[missClass];
+        }
+    }
+
+    if (network != nullptr) remoteAccess(lineAddr, isWrite, wasHit);
+    if (forwardsMisses) memoryAccess(lineAddr, isWrite, wasHit);
+
+#ifdef CACHESIM_SET_STATS
+    set_stats_t &ss = setStats[bank * nSetsPerBank + set];
+    wasHit ? ++ss.hits : ++ss.misses;
+    ss.evictions += s.nE - nEBefore;
+#endif
 }
 
 
@@ -280,43 +890,433 @@ void HistogramCounter::dumpBinaryStats(const char * const outputFilepath) {
 }
 
 
-Network::Network() {
+Network::Network() : Network(-1) {
     // use placeholder of -1 for our global rank until we fill it in
-    this->ourGlobalRank = -1;
 }
 
-Network::Network(int ourGlobalRank) {
+Network::Network(int ourGlobalRank) : Network(ourGlobalRank, 0) {
+}
+
+/*
+ * Knowing the world size up front lets us size the per-destination counters
+ * once, instead of growing them as new destinations show up.
+ */
+Network::Network(int ourGlobalRank, int worldSize) {
+    assert(worldSize >= 0);
     this->ourGlobalRank = ourGlobalRank;
+    this->dests.resize(worldSize, dest_counters_t());
+    this->srcs.resize(worldSize, dest_counters_t());
+    this->topology = nullptr;
+    this->byteHops = 0;
+
+    this->windowLength = 0;
+    this->windowClock = nullptr;
+    this->curWindow = 0;
+    this->curWindowBytes = nullptr;
+
+    this->timingEnabled = false;
+    this->cyclesPerByte = 0;
+    this->hopLatency = 0;
+    this->injectionOverhead = 0;
+    this->nUntimedMsgs = 0;
 }
 
 void Network::setOurGlobalRank(int ourGlobalRank) {
     this->ourGlobalRank = ourGlobalRank;
 }
 
-void Network::sendTo(int destID, size_t nBytes) {
-    destBytes[destID] += nBytes;
+int Network::getOurGlobalRank() {
+    return ourGlobalRank;
+}
+
+/*
+ * Routes every subsequent send over topology, accumulating bytes per link and
+ * total byte-hops. Our global rank must be set (and in the topology) first.
+ */
+void Network::setTopology(const Topology *topology) {
+    this->topology = topology;
+    linkBytes = std::vector<size_t>(topology->getNLinks(), 0);
+    byteHops = 0;
+    if (timingEnabled) resetTimingModel();
+}
+
+void Network::growDests(int destID) {
+    assert(destID >= 0);
+    dests.resize(destID + 1, dest_counters_t());
+}
+
+void Network::routeSend(int destID, size_t nBytes) {
+    topology->route(ourGlobalRank, destID, route);
+    for (uint32_t link : route) linkBytes[link] += nBytes;
+    byteHops += nBytes * route.size();
+}
+
+/*
+ * Starts keeping per-destination bytes in fixed-length time windows. Times
+ * come from the timestamp passed to sendTo(), or from the window clock.
+ */
+void Network::enableTimeWindows(uint64_t windowLength) {
+    assert(windowLength > 0);
+    this->windowLength = windowLength;
+    windows.clear();
+    curWindowBytes = nullptr;
+    linkBusy.clear();
+}
+
+/*
+ * Stamps sends that don't pass a timestamp with *clock; e.g., pass
+ * SimpleCache::getAccessCounter() to window by a companion cache's accesses.
+ */
+void Network::setWindowClock(const uint64_t *clock) {
+    this->windowClock = clock;
+}
+
+void Network::switchWindow(uint64_t window) {
+    curWindow = window;
+    curWindowBytes = &windows[window];
+}
+
+/*
+ * Starts timing every send that has a time (from its timestamp, or the window
+ * clock; see sendTo()): a message waits injectionOverhead cycles, then
+ * crosses our injection link and each link of its route (if there's a
+ * topology). Each link takes nBytes / linkBytesPerCycle cycles to serialize
+ * the message, and is busy meanwhile, so later messages queue behind it; the
+ * head moves on to the next link after hopLatency cycles (cut-through), and
+ * the message arrives once its tail has crossed the last link.
+ *
+ * Only this rank's own messages contend with each other. Link utilization is
+ * kept per time window if time windows are enabled.
+ */
+void Network::enableTimingModel(double linkBytesPerCycle, uint64_t hopLatency,
+        uint64_t injectionOverhead) {
+    assert(linkBytesPerCycle > 0);
+    this->timingEnabled = true;
+    this->cyclesPerByte = 1.0 / linkBytesPerCycle;
+    this->hopLatency = hopLatency;
+    this->injectionOverhead = injectionOverhead;
+    resetTimingModel();
+}
+
+void Network::resetTimingModel() {
+    linkBusyUntil = std::vector<uint64_t>(getInjectionLink() + 1, 0);
+    latencies.clear();
+    queueingDelays.clear();
+    nUntimedMsgs = 0;
+    linkBusy.clear();
+}
+
+void Network::timeSend(size_t nBytes, uint64_t timestamp) {
+    uint64_t nCycles = (uint64_t) ceil(double(nBytes) * cyclesPerByte);
+    uint64_t headAt = timestamp + injectionOverhead;
+    uint64_t queued = 0;
+
+    size_t nHops = topology != nullptr ? route.size() : 0;
+    for (size_t hop = 0; hop <= nHops; ++hop) {
+        uint32_t link = hop == 0 ? getInjectionLink() : route[hop - 1];
+        uint64_t start = std::max(headAt, linkBusyUntil[link]);
+        queued += start - headAt;
+        linkBusyUntil[link] = start + nCycles;
+        if (windowLength != 0) addLinkBusy(link, start, nCycles);
+        headAt = start + hopLatency;
+    }
+
+    latencies.record(headAt + nCycles - timestamp);
+    queueingDelays.record(queued);
+}
+
+/*
+ * Charges link with being busy over [start, start + nCycles), split across
+ * the windows that interval overlaps.
+ */
+void Network::addLinkBusy(uint32_t link, uint64_t start, uint64_t nCycles) {
+    while (nCycles != 0) {
+        uint64_t window = start / windowLength;
+        uint64_t inWindow = std::min(nCycles,
+                (window + 1) * windowLength - start);
+
+        std::vector<uint64_t> &busy = linkBusy[window];
+        if (busy.empty()) busy.resize(linkBusyUntil.size(), 0);
+        busy[link] += inWindow;
+
+        start += inWindow;
+        nCycles -= inWindow;
+    }
+}
+
+/*
+ * Equivalent to sendTo(destIDs[i], nBytes[i]) for each i, in order.
+ */
+void Network::sendToBatch(const int *destIDs, const size_t *nBytes,
+        size_t n) {
+    for (size_t i = 0; i < n; ++i) sendTo(destIDs[i], nBytes[i]);
+}
+
+/*
+ * Records a message srcID sent us, e.g., the response to a request we sent.
+ * Only the per-source counters see it (it isn't routed, windowed or timed).
+ */
+void Network::receiveFrom(int srcID, size_t nBytes) {
+    assert(srcID >= 0);
+    if (size_t(srcID) >= srcs.size()) {
+        srcs.resize(srcID + 1, dest_counters_t());
+    }
+    srcs[srcID].nBytes += nBytes;
+    ++srcs[srcID].nMsgs;
 }
 
 void Network::zeroStatsCounters() {
-    destBytes.clear();
+    std::fill(dests.begin(), dests.end(), dest_counters_t());
+    std::fill(srcs.begin(), srcs.end(), dest_counters_t());
+    msgSizes.clear();
+    std::fill(linkBytes.begin(), linkBytes.end(), 0);
+    byteHops = 0;
+    windows.clear();
+    curWindowBytes = nullptr;
+    if (timingEnabled) resetTimingModel();
+}
+
+size_t Network::getNDests() {
+    return dests.size();
+}
+
+size_t Network::getBytesTo(int destID) {
+    return size_t(destID) < dests.size() ? dests[destID].nBytes : 0;
+}
+
+size_t Network::getMsgsTo(int destID) {
+    return size_t(destID) < dests.size() ? dests[destID].nMsgs : 0;
+}
+
+size_t Network::getBytesFrom(int srcID) {
+    return size_t(srcID) < srcs.size() ? srcs[srcID].nBytes : 0;
+}
+
+const Histogram &Network::getMsgSizeHistogram() {
+    return msgSizes;
+}
+
+const std::vector<size_t> &Network::getLinkBytes() {
+    return linkBytes;
+}
+
+size_t Network::getByteHops() {
+    return byteHops;
+}
+
+/*
+ * Per-message latency (send to arrival of the last byte), in cycles.
+ */
+const Histogram &Network::getLatencyHistogram() {
+    return latencies;
+}
+
+const Histogram &Network::getQueueingHistogram() {
+    return queueingDelays;
+}
+
+/*
+ * Sends the timing model skipped, for lack of a timestamp or window clock.
+ */
+size_t Network::getNUntimedMsgs() {
+    return nUntimedMsgs;
+}
+
+/*
+ * Our injection link's ID, which follows the topology's links (or is 0,
+ * without a topology).
+ */
+uint32_t Network::getInjectionLink() {
+    return topology != nullptr ? topology->getNLinks() : 0;
+}
+
+/*
+ * Returns the fraction of the given time window that link was busy.
+ */
+double Network::getLinkUtilization(uint32_t link, uint64_t window) {
+    auto it = linkBusy.find(window);
+    if (it == linkBusy.end() or link >= it->second.size()) return 0.0;
+    return double(it->second[link]) / double(windowLength);
 }
 
 void Network::dumpTextStats(FILE * const f) {
     fprintf(f, "------------ Network Statistics ------------\n");
 
     // just do the total summation within the print loop itself
-    size_t totalBytesSent = 0;
-    for (auto &kv : destBytes) {
-        int dest = kv.first;
-        size_t nBytes = kv.second;
-        fprintf(f, "%d => %d : %zu bytes\n", ourGlobalRank, dest, nBytes);
+    size_t totalBytesSent = 0, totalMsgsSent = 0;
+    for (size_t dest = 0; dest < dests.size(); ++dest) {
+        size_t nBytes = dests[dest].nBytes;
+        size_t nMsgs = dests[dest].nMsgs;
+        if (nMsgs == 0) continue;
+        fprintf(f, "%d => %zu : %zu bytes, %zu msgs\n", ourGlobalRank, dest,
+                nBytes, nMsgs);
 
         totalBytesSent += nBytes;
+        totalMsgsSent += nMsgs;
     }
 
     fprintf(f, "Total bytes sent by us (%d): %zu\n", ourGlobalRank,
             totalBytesSent);
+    fprintf(f, "Total msgs sent by us (%d): %zu\n", ourGlobalRank,
+            totalMsgsSent);
+    msgSizes.dumpText(f, "Msg size (bytes) ");
+
+    size_t totalBytesReceived = 0;
+    for (size_t src = 0; src < srcs.size(); ++src) {
+        if (srcs[src].nMsgs == 0) continue;
+        fprintf(f, "%d <= %zu : %zu bytes, %zu msgs\n", ourGlobalRank, src,
+                srcs[src].nBytes, srcs[src].nMsgs);
+        totalBytesReceived += srcs[src].nBytes;
+    }
+    if (totalBytesReceived != 0) {
+        fprintf(f, "Total bytes received by us (%d): %zu\n", ourGlobalRank,
+                totalBytesReceived);
+    }
+
+    if (topology != nullptr) {
+        fprintf(f, "Byte-hops over %s: %zu (%.2f hops/byte)\n",
+                Topology::name(topology->getKind()), byteHops,
+                totalBytesSent == 0 ? 0.0 :
+                double(byteHops) / double(totalBytesSent));
+
+        // report the hottest links, most-loaded first
+        std::vector<uint32_t> links;
+        for (size_t l = 0; l < linkBytes.size(); ++l) {
+            if (linkBytes[l] != 0) links.push_back(l);
+        }
+        size_t nHot = std::min(links.size(), size_t(10));
+        std::partial_sort(links.begin(), links.begin() + nHot, links.end(),
+                [&](uint32_t a, uint32_t b) {
+                    return linkBytes[a] > linkBytes[b];
+                });
+        for (size_t i = 0; i < nHot; ++i) {
+            fprintf(f, "Hot link %s : %zu bytes\n",
+                    topology->linkName(links[i]).c_str(), linkBytes[links[i]]);
+        }
+    }
+
+    if (!windows.empty()) {
+        // the mean is over every window in the span, empty ones included,
+        // and only counts windowed bytes (not ones sent before windowing)
+        size_t peakBytes = 0, windowedBytes = 0;
+        uint64_t peakWindow = 0;
+        for (auto &kv : windows) {
+            size_t windowBytes = 0;
+            for (size_t nBytes : kv.second) windowBytes += nBytes;
+            windowedBytes += windowBytes;
+            if (windowBytes > peakBytes) {
+                peakBytes = windowBytes;
+                peakWindow = kv.first;
+            }
+        }
+        uint64_t firstWindow = windows.begin()->first;
+        uint64_t nWindows = windows.rbegin()->first - firstWindow + 1;
+        double meanBytes = double(windowedBytes) / double(nWindows);
+        fprintf(f, "Windows: %zu x %zu; peak window %zu: %zu bytes "
+                "(%.2fx mean)\n", (size_t) nWindows, (size_t) windowLength,
+                (size_t) peakWindow, peakBytes,
+                meanBytes == 0 ? 0.0 : double(peakBytes) / meanBytes);
+    }
+
+    if (timingEnabled) {
+        latencies.dumpText(f, "Msg latency (cycles) ");
+        fprintf(f, "Msg queueing (cycles) \tmean: %.2f  p99: %zu  max: %zu\n",
+                queueingDelays.getMean(),
+                (size_t) queueingDelays.percentile(99),
+                (size_t) queueingDelays.getMax());
+        if (nUntimedMsgs != 0) {
+            fprintf(f, "Msgs not timed (no timestamp or window clock): "
+                    "%zu\n", nUntimedMsgs);
+        }
+
+        // report the busiest link in the busiest window
+        uint64_t peakBusy = 0, peakWindow = 0;
+        size_t peakLink = 0;
+        for (auto &kv : linkBusy) {
+            for (size_t l = 0; l < kv.second.size(); ++l) {
+                if (kv.second[l] > peakBusy) {
+                    peakBusy = kv.second[l];
+                    peakWindow = kv.first;
+                    peakLink = l;
+                }
+            }
+        }
+        if (peakBusy != 0) {
+            fprintf(f, "Peak link utilization: %s in window %zu: %.2f%%\n",
+                    peakLink == getInjectionLink() ? "injection" :
+                    topology->linkName(peakLink).c_str(),
+                    (size_t) peakWindow,
+                    100.0 * double(peakBusy) / double(windowLength));
+        }
+    }
+}
+
+/*
+ * Dumps the time-windowed traffic as a binary matrix (little-endian), with
+ * a row per window that had traffic:
+ *   char[4]  magic ("CSTW")
+ *   uint32_t version (2)
+ *   int64_t  ourGlobalRank
+ *   uint64_t windowLength, nWindows, nDests
+ *   nWindows x (uint64_t window, nDests x uint64_t bytes), by window
+ */
+void Network::dumpTimeSeries(const char * const outputFilepath) {
+    const char magic[4] = { 'C', 'S', 'T', 'W' };
+    uint32_t version = 2;
+    int64_t rank = ourGlobalRank;
+    uint64_t header[3] = { windowLength, windows.size(), dests.size() };
 
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    of.write(magic, sizeof(magic));
+    of.write((char *)&version, sizeof(version));
+    of.write((char *)&rank, sizeof(rank));
+    of.write((char *)header, sizeof(header));
+
+    std::vector<uint64_t> row(dests.size());
+    for (auto &kv : windows) {
+        uint64_t window = kv.first;
+        std::fill(row.begin(), row.end(), 0);
+        std::copy(kv.second.begin(), kv.second.end(), row.begin());
+        of.write((char *)&window, sizeof(window));
+        of.write((char *)row.data(), row.size() * sizeof(uint64_t));
+    }
+
+    of.close();
+}
+
+/*
+ * Dumps per-window link busy cycles as a binary matrix (little-endian), with
+ * a row per window in which some link was busy, like dumpTimeSeries():
+ *   char[4]  magic ("CSLU")
+ *   uint32_t version (2)
+ *   int64_t  ourGlobalRank
+ *   uint64_t windowLength, nWindows, nLinks
+ *   nWindows x (uint64_t window, nLinks x uint64_t busy cycles), by window
+ *   (the injection link is last)
+ */
+void Network::dumpLinkUtilization(const char * const outputFilepath) {
+    const char magic[4] = { 'C', 'S', 'L', 'U' };
+    uint32_t version = 2;
+    int64_t rank = ourGlobalRank;
+    uint64_t header[3] = { windowLength, linkBusy.size(),
+            linkBusyUntil.size() };
+
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    of.write(magic, sizeof(magic));
+    of.write((char *)&version, sizeof(version));
+    of.write((char *)&rank, sizeof(rank));
+    of.write((char *)header, sizeof(header));
+
+    std::vector<uint64_t> row(linkBusyUntil.size());
+    for (auto &kv : linkBusy) {
+        uint64_t window = kv.first;
+        std::fill(row.begin(), row.end(), 0);
+        std::copy(kv.second.begin(), kv.second.end(), row.begin());
+        of.write((char *)&window, sizeof(window));
+        of.write((char *)row.data(), row.size() * sizeof(uint64_t));
+    }
+
+    of.close();
 }
 
 void Network::dumpTextStats(const char * const outputFilepath) {
@@ -328,7 +1328,8 @@ void Network::dumpTextStats(const char * const outputFilepath) {
 
 /* Base class definitions */
 Cache::Cache(size_t L1NLines, size_t L1NWays, size_t L2NLines, size_t L2NWays,
-        size_t L2NBanks, size_t cacheLineNBytes) {
+        size_t L2NBanks, size_t cacheLineNBytes, bank_hash_t L2BankHash) :
+        L2BankHasher(L2BankHash, L2NBanks, log2(cacheLineNBytes)) {
     this->L1NLines = L1NLines;
     this->L1NWays = L1NWays;
     assert(L1NLines % L1NWays == 0);
@@ -345,16 +1346,35 @@ Cache::Cache(size_t L1NLines, size_t L1NWays, size_t L2NLines, size_t L2NWays,
     memset(&this->s, 0, sizeof(this->s));
 
     this->cacheLineSizeLog2 = log2(cacheLineNBytes);
-}
 
-inline uint32_t Cache::fastHash(line_addr_t lineAddr, uint64_t maxSize) {
-    uint32_t res = 0;
-    uint64_t tmp = lineAddr;
-    for (uint32_t i = 0; i < 4; i++) {
-        res ^= (uint32_t) ( ((uint64_t)0xffff) & tmp);
-        tmp = tmp >> 16;
-    }
-    return (res % maxSize);
+    this->L2BankAccesses = std::vector<size_t>(L2NBanks, 0);
+    this->nAccesses = 0;
+#ifdef CACHESIM_SET_STATS
+    this->L1SetStats = std::vector<set_stats_t>(L1NSets);
+    this->L2SetStats = std::vector<set_stats_t>(L2NBanks * L2NSetsPerBank);
+#endif
+
+    this->NUCAEnabled = false;
+    this->NUCAGridWidth = 0;
+    this->NUCAGridHeight = 0;
+    this->NUCABaseLatency = 0;
+    this->NUCAHopLatency = 0;
+    this->curCore = 0;
+
+    this->timingEnabled = false;
+    this->L1HitLatency = 0;
+    this->L2HitLatency = 0;
+    this->memLatency = 0;
+
+    this->issueInterval = 0;
+    this->clock = 0;
+    this->statsStartCycle = 0;
+    this->lastDone = 0;
+
+    this->L2BankClock = nullptr;
+    this->dram = nullptr;
+    this->missTrace = nullptr;
+    this->forwardsMisses = false;
 }
 
 inline line_addr_t Cache::addrToLineAddr(intptr_t addr) {
@@ -416,6 +1436,55 @@ void Cache::computeStats() {
         s.L2WMP = double(s.L2WM) / double(s.nW);
     }
 
+    s.L2BankImbalance = computeBankImbalance(L2BankAccesses);
+
+    if (L2BankQueues) {
+        s.L2BankConflicts = 0;
+        for (size_t b = 0; b < L2NBanks; ++b) {
+            s.L2BankConflicts += L2BankQueues->getNConflicts(b);
+        }
+        s.L2BankQueueingCycles = L2BankQueues->getTotalDelay();
+    }
+
+    if (timingEnabled) {
+        size_t nL1Hits = s.L1RH + s.L1WH;
+        size_t nL2Hits = s.L2RH + s.L2WH;
+        size_t nMemAccesses = s.L2RM + s.L2WM;
+
+        accessLatencies.clear();
+        if (L1MSHRs) {
+            // overlapping misses: latencies were recorded as they happened
+            if (NUCAEnabled) foldNUCACounts();
+            accessLatencies.merge(MSHRAccessLatencies);
+            s.elapsedCycles = std::max(clock, lastDone) - statsStartCycle;
+        }
+        else if (NUCAEnabled) {
+            accessLatencies.record(L1HitLatency, nL1Hits);
+            foldNUCACounts();
+            accessLatencies.merge(NUCAAccessLatencies);
+        }
+        else {
+            accessLatencies.record(L1HitLatency, nL1Hits);
+            accessLatencies.record(L1HitLatency + L2HitLatency, nL2Hits);
+            accessLatencies.record(L1HitLatency + L2HitLatency + memLatency,
+                    nMemAccesses);
+        }
+
+        s.totalCycles = accessLatencies.getSum();
+        s.stallCycles = s.totalCycles -
+                (nL1Hits + nL2Hits + nMemAccesses) * L1HitLatency;
+        s.AMAT = accessLatencies.getMean();
+
+        // blocking accesses wait out their L2 bank's queue on top of that
+        // (the MSHR model already counted it)
+        if (L2BankQueues and !L1MSHRs) {
+            size_t n = nL1Hits + nL2Hits + nMemAccesses;
+            s.totalCycles += s.L2BankQueueingCycles;
+            s.stallCycles += s.L2BankQueueingCycles;
+            s.AMAT = n == 0 ? 0.0 : double(s.totalCycles) / double(n);
+        }
+    }
+
     s.computedFinalStats = true;
 }
 
@@ -423,12 +1492,294 @@ Cache::stats_t *Cache::getStats() {
     return &s;
 }
 
+/*
+ * Whether anything beyond the plain hit/miss simulation is enabled or
+ * attached (see SimpleCache::hasOptionalModels()).
+ */
+bool Cache::hasOptionalModels() {
+    return L2Classifier != nullptr or NUCAEnabled or timingEnabled or
+            L1MSHRs != nullptr or L2BankQueues != nullptr or forwardsMisses;
+}
+
+const std::vector<size_t> &Cache::getL2BankAccesses() {
+    return L2BankAccesses;
+}
+
+/*
+ * Returns a pointer to the count of accesses made so far, e.g., for use as a
+ * Network window clock.
+ */
+const uint64_t *Cache::getAccessCounter() {
+    return &nAccesses;
+}
+
+/*
+ * Starts splitting L2 read/write misses into compulsory, capacity, and
+ * conflict misses. Should be called before the first access.
+ */
+void Cache::enableMissClassification() {
+    L2Classifier.reset(new MissClassifier(L2NLines, cacheLineSizeLog2));
+}
+
+/*
+ * Starts charging every L2 hit by its distance on a gridWidth x gridHeight
+ * on-chip grid: baseLatency + hopLatency per hop from the requesting core to
+ * the line's bank. Banks start out row-major from (0, 0) and core 0 at (0, 0);
+ * move them with setL2BankPosition()/setCorePosition(), and pick the core
+ * making subsequent accesses with setCore().
+ */
+void Cache::enableNUCA(size_t gridWidth, size_t gridHeight,
+        uint32_t baseLatency, uint32_t hopLatency) {
+    assert(L2NBanks <= gridWidth * gridHeight);
+    NUCAEnabled = true;
+    NUCAGridWidth = gridWidth;
+    NUCAGridHeight = gridHeight;
+    NUCABaseLatency = baseLatency;
+    NUCAHopLatency = hopLatency;
+
+    L2BankPositions.resize(L2NBanks);
+    for (size_t bank = 0; bank < L2NBanks; ++bank) {
+        L2BankPositions[bank] = { uint32_t(bank % gridWidth),
+                uint32_t(bank / gridWidth) };
+    }
+    corePositions.assign(1, grid_pos_t{ 0, 0 });
+    L2HitLatencies.assign(1, Histogram());
+    NUCAHits.assign(L2NBanks, 0);
+    NUCAMisses.assign(L2NBanks, 0);
+    NUCAAccessLatencies.clear();
+    curCore = 0;
+    updateNUCALatencies();
+}
+
+void Cache::setL2BankPosition(size_t bank, uint32_t x, uint32_t y) {
+    assert(NUCAEnabled and bank < L2NBanks);
+    assert(x < NUCAGridWidth and y < NUCAGridHeight);
+    L2BankPositions[bank] = { x, y };
+    updateNUCALatencies();
+}
+
+void Cache::setCorePosition(int core, uint32_t x, uint32_t y) {
+    assert(NUCAEnabled and core >= 0);
+    assert(x < NUCAGridWidth and y < NUCAGridHeight);
+    if (size_t(core) >= corePositions.size()) {
+        corePositions.resize(core + 1, grid_pos_t{ 0, 0 });
+        L2HitLatencies.resize(core + 1, Histogram());
+        NUCAHits.resize((core + 1) * L2NBanks, 0);
+        NUCAMisses.resize((core + 1) * L2NBanks, 0);
+    }
+    corePositions[core] = { x, y };
+    updateNUCALatencies();
+}
+
+/*
+ * Attributes subsequent accesses to core (whose position must be set).
+ */
+void Cache::setCore(int core) {
+    assert(core >= 0 and size_t(core) < corePositions.size());
+    curCore = core;
+}
+
+const Histogram &Cache::getL2HitLatencies(int core) {
+    foldNUCACounts();
+    return L2HitLatencies[core];
+}
+
+/*
+ * Charges the pending L2 hits/misses at the current latencies. An L1 miss
+ * pays the L1 latency, then the NUCA latency to its bank, then (on an L2
+ * miss) the memory latency.
+ */
+void Cache::foldNUCACounts() {
+    for (size_t core = 0; core < corePositions.size(); ++core) {
+        for (size_t bank = 0; bank < L2NBanks; ++bank) {
+            size_t i = core * L2NBanks + bank;
+            if (NUCAHits[i] == 0 and NUCAMisses[i] == 0) continue;
+
+            uint64_t L2Latency = L1HitLatency + NUCALatency[i];
+            L2HitLatencies[core].record(NUCALatency[i], NUCAHits[i]);
+            NUCAAccessLatencies.record(L2Latency, NUCAHits[i]);
+            NUCAAccessLatencies.record(L2Latency + memLatency, NUCAMisses[i]);
+            NUCAHits[i] = 0;
+            NUCAMisses[i] = 0;
+        }
+    }
+}
+
+/*
+ * Sets the latency of an L1 hit, of an L2 hit on top of that (unless NUCA
+ * is enabled, which decides it per bank), and of memory on top of both. Call
+ * it before the first access, so that all accesses get charged the same way.
+ */
+void Cache::setLatencies(uint32_t L1HitLatency, uint32_t L2HitLatency,
+        uint32_t memLatency) {
+    if (NUCAEnabled) foldNUCACounts();
+    this->timingEnabled = true;
+    this->L1HitLatency = L1HitLatency;
+    this->L2HitLatency = L2HitLatency;
+    this->memLatency = memLatency;
+}
+
+/*
+ * Per-access latency distribution (as of the last computeStats()).
+ */
+const Histogram &Cache::getAccessLatencies() {
+    return accessLatencies;
+}
+
+/*
+ * Makes both levels non-blocking (needs setLatencies() first): the core
+ * issues an access every issueInterval cycles without waiting for misses.
+ * A primary miss takes an MSHR at its level, and accesses to a line whose
+ * fill is still in flight are secondary misses, which wait for that fill
+ * instead of going to the next level. When a level's MSHRs are all busy,
+ * its next primary miss waits for one; at the L1 that stalls the core.
+ */
+void Cache::enableMSHRs(size_t L1NMSHRs, size_t L2NMSHRs,
+        uint32_t issueInterval) {
+    assert(timingEnabled);
+    L1MSHRs.reset(new MSHRFile(L1NMSHRs));
+    L2MSHRs.reset(new MSHRFile(L2NMSHRs));
+    this->issueInterval = issueInterval;
+    statsStartCycle = clock;
+    MSHRAccessLatencies.clear();
+}
+
+void Cache::timeNonBlocking(line_addr_t line, size_t L2Bank, bool wasL1Hit,
+        bool wasL2Hit) {
+    uint64_t now = clock;
+    clock += issueInterval;
+
+    uint64_t readyAt, done;
+    if (L1MSHRs->inFlight(line, now, readyAt)) {
+        ++s.L1SecondaryMisses;
+        done = std::max(readyAt, now + L1HitLatency);
+    }
+    else if (wasL1Hit) {
+        done = now + L1HitLatency;
+    }
+    else {
+        size_t L1Entry;
+        uint64_t issueAt = L1MSHRs->acquire(now, L1Entry);
+        clock += issueAt - now;     // a full L1 MSHR file blocks the core
+
+        uint64_t L2Latency = NUCAEnabled ?
+                NUCALatency[curCore * L2NBanks + L2Bank] : L2HitLatency;
+        uint64_t atL2 = issueAt + L1HitLatency;
+        if (L2BankQueues) atL2 += L2BankQueues->arrive(L2Bank, atL2);
+        if (L2MSHRs->inFlight(line, atL2, readyAt)) {
+            ++s.L2SecondaryMisses;
+            done = std::max(readyAt, atL2 + L2Latency);
+        }
+        else if (wasL2Hit) {
+            done = atL2 + L2Latency;
+        }
+        else {
+            size_t L2Entry;
+            uint64_t memIssueAt = L2MSHRs->acquire(atL2 + L2Latency, L2Entry);
+            done = memIssueAt + memLatency;
+            L2MSHRs->fill(L2Entry, line, memIssueAt, done);
+            ++s.memRequests;
+        }
+        L1MSHRs->fill(L1Entry, line, issueAt, done);
+    }
+
+    lastDone = std::max(lastDone, done);
+    MSHRAccessLatencies.record(done - now);
+}
+
+void Cache::updateNUCALatencies() {
+    // past accesses keep the latencies they had
+    if (!NUCAHits.empty()) foldNUCACounts();
+
+    NUCALatency.resize(corePositions.size() * L2NBanks);
+    for (size_t core = 0; core < corePositions.size(); ++core) {
+        const grid_pos_t &c = corePositions[core];
+        for (size_t bank = 0; bank < L2NBanks; ++bank) {
+            const grid_pos_t &b = L2BankPositions[bank];
+            uint32_t hops = (c.x > b.x ? c.x - b.x : b.x - c.x) +
+                    (c.y > b.y ? c.y - b.y : b.y - c.y);
+            NUCALatency[core * L2NBanks + bank] = NUCABaseLatency +
+                    NUCAHopLatency * hops;
+        }
+    }
+}
+
+/*
+ * Models each L2 bank as a server that takes serviceCycles per L1 miss: a
+ * miss arriving while its bank is busy waits for it (see BankQueues). With
+ * MSHRs enabled, the wait is part of the miss's latency.
+ */
+void Cache::enableL2BankQueueing(uint32_t serviceCycles,
+        const uint64_t *clock) {
+    L2BankQueues.reset(new BankQueues(L2NBanks, serviceCycles));
+    this->L2BankClock = clock;
+}
+
+const BankQueues *Cache::getL2BankQueues() {
+    return L2BankQueues.get();
+}
+
+/*
+ * Sends every L2 miss to dram as a line read, and every L2 eviction of a
+ * line written since it was cached as a line write. Requests are stamped
+ * one access per cycle, or with the MSHR model's clock if enabled. Flush
+ * dram before reading its stats.
+ */
+void Cache::attachDRAM(DRAM *dram) {
+    this->dram = dram;
+    if (!forwardsMisses) dirtyLines.clear();
+    forwardsMisses = dram != nullptr or missTrace != nullptr;
+}
+
+/*
+ * Streams the same L2 misses and writebacks attachDRAM() would send to
+ * memory into missTrace, stamped with the index of the access causing each.
+ */
+void Cache::setMissTrace(MissTraceWriter *missTrace) {
+    this->missTrace = missTrace;
+    if (!forwardsMisses) dirtyLines.clear();
+    forwardsMisses = dram != nullptr or missTrace != nullptr;
+}
+
+void Cache::memoryAccess(line_addr_t line, bool isWrite, bool wasL2Hit,
+        bool L2Evicted, line_addr_t L2Victim) {
+    uint64_t index = nAccesses - 1;
+    uint64_t now = L1MSHRs ? clock : index;
+    if (L2Evicted and dirtyLines.erase(L2Victim) != 0) {
+        if (dram != nullptr) dram->request(L2Victim, true, now);
+        if (missTrace != nullptr) missTrace->record(index, L2Victim, true);
+        ++s.memWritebacks;
+    }
+    if (!wasL2Hit) {
+        if (dram != nullptr) dram->request(line, false, now);
+        if (missTrace != nullptr) missTrace->record(index, line, false);
+        ++s.memReads;
+    }
+    if (isWrite) dirtyLines.insert(line);
+}
+
 /*
  * Used for terminating the warmup phase. Zeroes stats counters while leaving
  * the maps and lists that actually store the accessed locations intact.
  */
 void Cache::zeroStatsCounters() {
     memset(&s, 0, sizeof(s));
+    std::fill(L2BankAccesses.begin(), L2BankAccesses.end(), 0);
+    for (auto &h : L2HitLatencies) h.clear();
+    std::fill(NUCAHits.begin(), NUCAHits.end(), 0);
+    std::fill(NUCAMisses.begin(), NUCAMisses.end(), 0);
+    NUCAAccessLatencies.clear();
+    if (L1MSHRs) {
+        L1MSHRs->clearStats();
+        L2MSHRs->clearStats();
+    }
+    MSHRAccessLatencies.clear();
+    statsStartCycle = clock;
+    if (L2BankQueues) L2BankQueues->clearStats();
+#ifdef CACHESIM_SET_STATS
+    std::fill(L1SetStats.begin(), L1SetStats.end(), set_stats_t());
+    std::fill(L2SetStats.begin(), L2SetStats.end(), set_stats_t());
+#endif
 }
 
 void Cache::dumpTextStats(FILE * const f) {
@@ -445,13 +1796,99 @@ void Cache::dumpTextStats(FILE * const f) {
             s.L2RHP*100, s.L2WH, s.L2WHP*100);
     fprintf(f, "Mem:   RH: %zu (%.2f%%)    WH: %zu (%.2f%%)\n", s.L2RM,
             s.L2RMP*100, s.L2WM, s.L2WMP*100);
+
+    if (L2NBanks > 1) {
+        fprintf(f, "L2 banks: hash %s, imbalance %.3f (max/mean)\n",
+                BankHasher::name(L2BankHasher.getType()), s.L2BankImbalance);
+        dumpBankAccesses(f, "L2_BANK_", L2BankAccesses);
+    }
+    if (L2BankQueues) {
+        fprintf(f, "L2 bank queues: service %u cycles, %zu conflicts, %zu "
+                "cycles waiting\n", L2BankQueues->getServiceCycles(),
+                s.L2BankConflicts, s.L2BankQueueingCycles);
+        L2BankQueues->dumpText(f, "L2_BANK_QUEUE_");
+    }
+    if (forwardsMisses) {
+        fprintf(f, "Mem traffic: reads: %zu    writebacks: %zu\n",
+                s.memReads, s.memWritebacks);
+    }
+
+    if (L2Classifier) {
+        fprintf(f, "Mem:  ");
+        for (int c = 0; c < N_MISS_CLASSES; ++c) {
+            fprintf(f, "  %s: RH %zu WH %zu",
+                    MissClassifier::name(miss_class_t(c)),
+                    s.L2RMByClass[c], s.L2WMByClass[c]);
+        }
+        fprintf(f, "\n");
+        dumpFootprint(f, "L2_FOOTPRINT_", L2Classifier->getFootprint());
+    }
+
+    if (NUCAEnabled) {
+        foldNUCACounts();
+        fprintf(f, "NUCA: %zux%zu grid, %u + %u/hop cycles\n", NUCAGridWidth,
+                NUCAGridHeight, NUCABaseLatency, NUCAHopLatency);
+        for (size_t core = 0; core < L2HitLatencies.size(); ++core) {
+            const Histogram &h = L2HitLatencies[core];
+            fprintf(f, "Core %zu (%u,%u) L2 hit latency: n: %zu  mean: %.2f  "
+                    "p50: %zu  p99: %zu  max: %zu\n", core,
+                    corePositions[core].x, corePositions[core].y,
+                    (size_t) h.getCount(), h.getMean(),
+                    (size_t) h.percentile(50), (size_t) h.percentile(99),
+                    (size_t) h.getMax());
+        }
+    }
+
+    if (timingEnabled) {
+        fprintf(f, "AMAT: %.2f cycles    total: %zu cycles    stalls: %zu "
+                "cycles\n", s.AMAT, s.totalCycles, s.stallCycles);
+        accessLatencies.dumpText(f, "Access latency (cycles) ");
+    }
+
+    if (L1MSHRs) {
+        fprintf(f, "Elapsed: %zu cycles    memory requests: %zu\n",
+                s.elapsedCycles, s.memRequests);
+        const char *names[2] = { "L1", "L2" };
+        MSHRFile *files[2] = { L1MSHRs.get(), L2MSHRs.get() };
+        size_t secondaries[2] = { s.L1SecondaryMisses, s.L2SecondaryMisses };
+        for (int l = 0; l < 2; ++l) {
+            fprintf(f, "%s MSHRs: %zu    mean occupancy: %.2f    secondary "
+                    "misses: %zu    full stalls: %zu (%zu cycles)\n",
+                    names[l], files[l]->getNEntries(),
+                    files[l]->getMeanOccupancy(s.elapsedCycles),
+                    secondaries[l], files[l]->getNFullStalls(),
+                    (size_t) files[l]->getStallCycles());
+        }
+    }
+#ifdef CACHESIM_SET_STATS
+    dumpTextSetStats(f, "L1_SETSTATS_", 1, L1NSets, L1SetStats);
+    dumpTextSetStats(f, "L2_SETSTATS_BANK_", L2NBanks, L2NSetsPerBank,
+            L2SetStats);
+#endif
+}
+
+/*
+ * Dumps the L1 and then the L2 per-set counters as two consecutive heatmap
+ * sections (format described above writeSetStatsHeatmap()).
+ */
+void Cache::dumpSetStats(const char * const outputFilepath) {
+#ifdef CACHESIM_SET_STATS
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    writeSetStatsHeatmap(of, 1, L1NSets, L1SetStats);
+    writeSetStatsHeatmap(of, L2NBanks, L2NSetsPerBank, L2SetStats);
+    of.close();
+#else
+    fprintf(stderr, "Per-set stats not compiled in (need SET_STATS=1); "
+            "not writing %s\n", outputFilepath);
+#endif
 }
 
 
 /* Derived class definitions */
 LRUCache::LRUCache(size_t L1NLines, size_t L1NWays, size_t L2NLines,
-        size_t L2NWays, size_t L2NBanks, size_t cacheLineNBytes) :
-        Cache(L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes) {
+        size_t L2NWays, size_t L2NBanks, size_t cacheLineNBytes,
+        bank_hash_t L2BankHash) : Cache(L1NLines, L1NWays, L2NLines, L2NWays,
+        L2NBanks, cacheLineNBytes, L2BankHash) {
 
     // initialize the 1-D maps + lists (no banks in L1)
     L1Maps = std::vector<map_t>(L1NSets);
@@ -466,23 +1903,106 @@ LRUCache::LRUCache(size_t L1NLines, size_t L1NWays, size_t L2NLines,
     std::cerr << "done initializing data structures" << std::endl;
 }
 
+/*
+ * Equivalent to access(addrs[i], isWrites[i]) for each i, in order.
+ */
+void LRUCache::accessBatch(const uintptr_t *addrs, const uint8_t *isWrites,
+        size_t n) {
+    for (size_t i = 0; i < n; ++i) access(addrs[i], isWrites[i]);
+}
+
 void LRUCache::access(uintptr_t addr, bool isWrite) {
     line_addr_t lineAddr = addrToLineAddr(addr);
+    bool L1Evicted;
+    bool wasL1Hit = accessL1(lineAddr, L1Evicted);
+    accessL2(lineAddr, isWrite, wasL1Hit, L1Evicted);
+}
 
+/*
+ * Equivalent to accessBatch(), but with the L1 on this thread and the rest
+ * (accessL2()) on another, fed through a ring of ringNRecords. The L1 stage
+ * touches nothing but the L1's maps and lists, and the L2 stage sees the
+ * same calls in the same order, so every stat matches a serial run.
+ */
+void LRUCache::accessBatchPipelined(const uintptr_t *addrs,
+        const uint8_t *isWrites, size_t n, size_t ringNRecords) {
+    SPSCRing<l2_request_t> ring(ringNRecords);
+
+    std::thread L2Stage([this, &ring, n]() {
+        l2_request_t r;
+        for (size_t i = 0; i < n; ++i) {
+            ring.pop(r);
+            accessL2(r.line, r.isWrite, r.wasL1Hit, r.L1Evicted);
+        }
+    });
+
+    for (size_t i = 0; i < n; ++i) {
+        line_addr_t lineAddr = addrToLineAddr(addrs[i]);
+        bool L1Evicted;
+        bool wasL1Hit = accessL1(lineAddr, L1Evicted);
+        ring.push(l2_request_t{ lineAddr, isWrites[i], wasL1Hit, L1Evicted });
+    }
+    L2Stage.join();
+}
+
+/*
+ * Looks the line up in (and updates) the L1 only.
+ *
+ * Return value: whether it was an L1 hit.
+ */
+inline bool LRUCache::accessL1(line_addr_t lineAddr, bool &L1Evicted) {
     // NOTE: want constant propagation w/these, may not get it
     size_t L1Set = lineToLXSet(lineAddr, L1NSets);
-    size_t L2Bank = fastHash(lineAddr, L2NBanks);
-    size_t L2Set = lineToLXSet(lineAddr, L2NSetsPerBank);
 
     // retrieve the correct map and list for the Way
     auto &L1Map = L1Maps[L1Set];
     auto &L1List = L1Lists[L1Set];
+
+    bool L1WasFull = L1Map.size() == L1NWays;
+    bool wasL1Hit = touchLine(lineAddr, L1Map, L1List, L1NWays);
+    L1Evicted = !wasL1Hit and L1WasFull;
+    return wasL1Hit;
+}
+
+/*
+ * Everything access() does after the L1 lookup, which L1Filter replays skip.
+ */
+inline void LRUCache::accessL2(line_addr_t lineAddr, bool isWrite,
+        bool wasL1Hit, bool L1Evicted) {
+    size_t L2Bank = L2BankHasher.hash(lineAddr);
+    size_t L2Set = lineToLXSet(lineAddr, L2NSetsPerBank);
+    ++L2BankAccesses[L2Bank];
+    ++nAccesses;
+
     auto &L2Map = L2Maps[L2Bank][L2Set];
     auto &L2List = L2Lists[L2Bank][L2Set];
 
-    bool wasL1Hit = touchLine(lineAddr, L1Map, L1List, L1NWays);
+#ifdef CACHESIM_SET_STATS
+    bool L2WasFull = L2Map.size() == L2NWays;
+#endif
+
+    // the L2 victim (if any) is the LRU line, which touchLine() drops
+    bool L2Evicts = false;
+    line_addr_t L2Victim = 0;
+    if (forwardsMisses and L2Map.size() == L2NWays and
+            L2Map.count(lineAddr) == 0) {
+        L2Evicts = true;
+        L2Victim = L2List.front();
+    }
+
     bool wasL2Hit = touchLine(lineAddr, L2Map, L2List, L2NWays);
 
+#ifdef CACHESIM_SET_STATS
+    set_stats_t &L1SS = L1SetStats[lineToLXSet(lineAddr, L1NSets)];
+    set_stats_t &L2SS = L2SetStats[L2Bank * L2NSetsPerBank + L2Set];
+    wasL1Hit ? ++L1SS.hits : ++L1SS.misses;
+    wasL2Hit ? ++L2SS.hits : ++L2SS.misses;
+    if (L1Evicted) ++L1SS.evictions;
+    if (!wasL2Hit and L2WasFull) ++L2SS.evictions;
+#else
+    (void) L1Evicted;
+#endif
+
     if (!isWrite) {
         wasL1Hit ? ++s.L1RH : wasL2Hit ? ++s.L2RH : ++s.L2RM;
     }
@@ -490,4 +2010,72 @@ void LRUCache::access(uintptr_t addr, bool isWrite) {
         wasL1Hit ? ++s.L1WH : wasL2Hit ? ++s.L2WH : ++s.L2WM;
     }
 
+    if (NUCAEnabled and !wasL1Hit) {
+        size_t i = curCore * L2NBanks + L2Bank;
+        wasL2Hit ? ++NUCAHits[i] : ++NUCAMisses[i];
+    }
+
+    if (forwardsMisses) {
+        memoryAccess(lineAddr, isWrite, wasL2Hit, L2Evicts, L2Victim);
+    }
+
+    if (L1MSHRs) {
+        timeNonBlocking(lineAddr, L2Bank, wasL1Hit, wasL2Hit);
+    }
+    else if (L2BankQueues and !wasL1Hit) {
+        uint64_t now = L2BankClock != nullptr ? *L2BankClock : nAccesses - 1;
+        L2BankQueues->arrive(L2Bank, now);
+    }
+
+    // note: the L2 (and so its shadow) sees every access, not just L1 misses
+    if (L2Classifier) {
+        miss_class_t missClass = L2Classifier->access(lineAddr, true);
+        if (!wasL1Hit and !wasL2Hit) {
+            isWrite ? ++s.L2WMByClass[missClass] : ++s.L2RMByClass[missClass];
+        }
+    }
+}
+
+/*
+ * Further accesses to the line just accessed: hits in both levels that
+ * leave every LRU order as it was, so only the counters move.
+ */
+void LRUCache::repeatHits(line_addr_t lineAddr, size_t nReads,
+        size_t nWrites) {
+    size_t n = nReads + nWrites;
+    size_t L2Bank = L2BankHasher.hash(lineAddr);
+    L2BankAccesses[L2Bank] += n;
+    nAccesses += n;
+    s.L1RH += nReads;
+    s.L1WH += nWrites;
+    if (forwardsMisses and nWrites != 0) dirtyLines.insert(lineAddr);
+
+#ifdef CACHESIM_SET_STATS
+    size_t L2Set = lineToLXSet(lineAddr, L2NSetsPerBank);
+    L1SetStats[lineToLXSet(lineAddr, L1NSets)].hits += n;
+    L2SetStats[L2Bank * L2NSetsPerBank + L2Set].hits += n;
+#endif
+}
+
+/*
+ * Produces the same stats as calling access() on every access of the trace
+ * filter was built from, without simulating the L1 (see L1Filter). Per-
+ * access timing models (MSHRs, L2 bank queueing) need the real access
+ * stream, so they can't be enabled. The L1 contents aren't kept up to date,
+ * so don't mix this with access().
+ */
+void LRUCache::replayL1Filtered(const L1Filter &filter) {
+    assert(filter.getL1NLines() == L1NLines);
+    assert(filter.getL1NWays() == L1NWays);
+    assert(filter.getCacheLineNBytes() == size_t(1) << cacheLineSizeLog2);
+    assert(!L1MSHRs and !L2BankQueues);
+
+    for (const L1Filter::run_t &run : filter.getRuns()) {
+        accessL2(run.line, run.flags & L1Filter::RUN_WRITE,
+                run.flags & L1Filter::RUN_L1_HIT,
+                run.flags & L1Filter::RUN_L1_EVICTED);
+        if (run.nRepeatReads + run.nRepeatWrites != 0) {
+            repeatHits(run.line, run.nRepeatReads, run.nRepeatWrites);
+        }
+    }
 }
@@ -8,16 +8,46 @@
 #pragma once
 
 #include <list>
+#include <map>
+#include <memory>
 #include <stdbool.h>
 #include <stdint.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "AlignedAllocator.h"
+#include "BankHash.h"
+#include "BankQueues.h"
+#include "Histogram.h"
+#include "HomeMap.h"
+#include "MissClassifier.h"
+#include "MSHR.h"
+#include "Topology.h"
+
 typedef uintptr_t line_addr_t;
 typedef uintptr_t word_addr_t;
 typedef std::unordered_map<line_addr_t, std::list<line_addr_t>::iterator> map_t;
 typedef std::list<line_addr_t> list_t;
 
+/*
+ * Per-set hit/miss/eviction counters, kept in a dense array indexed by
+ * (bank * nSetsPerBank + set). They cost a store on every access, so they're
+ * only updated with -DCACHESIM_SET_STATS (`make SET_STATS=1`). The arrays
+ * are members either way (just left empty), so the class layout, and with
+ * it libCache's ABI, doesn't depend on the flag.
+ */
+typedef struct {
+    uint64_t hits, misses, evictions;
+} set_stats_t;
+
+class Network;
+class Directory;
+class DRAM;
+class MissTraceWriter;
+class L1Filter;
+class WorkStealingPool;
+
 class SimpleCache {
     public:
         typedef struct {
@@ -30,19 +60,54 @@ class SimpleCache {
             double RHP, RMP;
             double WHP, WMP;
             double EP;
+            double bankImbalance;   // max/mean accesses per bank
+
+            // 3C breakdown of RM/WM (only with enableMissClassification())
+            size_t RMByClass[N_MISS_CLASSES];
+            size_t WMByClass[N_MISS_CLASSES];
+
+            // remote-home traffic (only with attachNetwork())
+            size_t remoteMisses, remoteWritebacks;
+
+            // timing (only with setLatencies())
+            size_t totalCycles, stallCycles;
+            double AMAT;
+
+            // bank contention (only with enableBankQueueing())
+            size_t bankConflicts, bankQueueingCycles;
+
+            // memory traffic (only with attachDRAM() or setMissTrace())
+            size_t memReads, memWritebacks;
         } stats_t;
 
         SimpleCache(size_t nLines, size_t nWays, size_t nBanks,
-                size_t cacheLineNBytes, bool allocateOnWritesOnly);
+                size_t cacheLineNBytes, bool allocateOnWritesOnly,
+                bank_hash_t bankHash = BANK_HASH_FOLD);
         uint64_t getCacheLineSizeLog2();
         void computeStats();
+        static void computeRatios(stats_t &s);
         stats_t *getStats();
+        bool hasOptionalModels();
+        const std::vector<size_t> &getBankAccesses();
+        const uint64_t *getAccessCounter();
+        void enableMissClassification();
+        void setLatencies(uint32_t hitLatency, uint32_t memLatency);
+        const Histogram &getAccessLatencies();
+        void attachNetwork(Network *network, const HomeMap *homeMap,
+                size_t requestNBytes = 8);
+        void attachDirectory(Directory *directory, int node);
+        void enableBankQueueing(uint32_t serviceCycles,
+                const uint64_t *clock = nullptr);
+        const BankQueues *getBankQueues();
+        void attachDRAM(DRAM *dram);
+        void setMissTrace(MissTraceWriter *missTrace);
         void zeroStatsCounters();
         void dumpTextStats(FILE * const outputFile);
         void dumpTextStats(const char * const outputFilepath);
         void dumpBinaryStats(const char * const outputFilepath);
+        void dumpSetStats(const char * const outputFilepath);
 
-        // TODO forward (to higher cache levels or memory/RAMulator)
+        // TODO forward to higher cache levels (memory: see attachDRAM())
 
     protected:
         size_t nLines, nWays, nSetsPerBank, nBanks;
@@ -56,43 +121,219 @@ class SimpleCache {
 
         stats_t s;
         std::unordered_map<line_addr_t, miss_stats_t> misses;
+        uint64_t nAccesses;     // monotonic; not reset by zeroStatsCounters()
+
+        BankHasher bankHasher;
+        std::vector<size_t> bankAccesses;   // per-bank access histogram
+        std::vector<set_stats_t> setStats;  // [bank * nSetsPerBank + set]
+        std::unique_ptr<MissClassifier> classifier;     // null if disabled
+
+        // optional timing model; derived from the counters by computeStats()
+        bool timingEnabled;
+        uint32_t hitLatency, memLatency;
+        Histogram accessLatencies;
+
+        // optional distributed shared memory model (neither is owned)
+        Network *network;                   // null if not attached
+        const HomeMap *homeMap;
+        size_t requestNBytes;
+        std::unordered_set<line_addr_t> dirtyRemoteLines;
+
+        // optional coherence directory to tell about evictions (not owned)
+        Directory *directory;               // null if not attached
+        int directoryNode;
+
+        // optional bank contention model; accesses arrive at *bankClock, or
+        // one per cycle (at nAccesses) without a clock
+        std::unique_ptr<BankQueues> bankQueues;     // null if disabled
+        const uint64_t *bankClock;
+
+        // optional DRAM behind us and/or trace of what we'd send it (neither
+        // is owned): our misses, and the writebacks of lines written while
+        // cached
+        DRAM *dram;                         // null if not attached
+        MissTraceWriter *missTrace;         // null if not tracing
+        bool forwardsMisses;                // either of the above
+        std::unordered_set<line_addr_t> dirtyLines;
+        uint64_t curTimestamp;              // of the access in progress
 
         inline line_addr_t addrToLineAddr(intptr_t addr);
-        inline uint32_t fastHash(line_addr_t lineAddr, uint64_t maxSize);
         inline size_t lineToLXSet(line_addr_t lineAddr, size_t nSets);
         void logMiss(line_addr_t line, bool isWrite);
+        void remoteAccess(line_addr_t line, bool isWrite, bool wasHit);
+        void remoteEviction(line_addr_t line);
+        void memoryAccess(line_addr_t line, bool isWrite, bool wasHit);
+        void memoryEviction(line_addr_t line);
 };
 
 class LRUSimpleCache : public SimpleCache {
     public:
         LRUSimpleCache(size_t nLines, size_t nWays, size_t nBanks,
-                size_t cacheLineNBytes, bool allocateOnWritesOnly);
-        void access(uintptr_t addr, bool isWrite);
+                size_t cacheLineNBytes, bool allocateOnWritesOnly,
+                bank_hash_t bankHash = BANK_HASH_FOLD);
+        inline void access(uintptr_t addr, bool isWrite);
+        void access(uintptr_t addr, bool isWrite, uint64_t timestamp);
+        void accessBatch(const uintptr_t *addrs, const uint8_t *isWrites,
+                size_t n);
+        void accessBatchParallel(const uintptr_t *addrs,
+                const uint8_t *isWrites, size_t n, WorkStealingPool &pool,
+                size_t nChunks = 0);
         bool touchLine(line_addr_t lineAddr, map_t &map, list_t &list,
                 size_t nWays, bool allocateOnWritesOnly, bool isWrite);
+        bool touchLine(line_addr_t lineAddr, FullyAssocLRU &faSet,
+                bool allocateOnWritesOnly, bool isWrite);
+        bool containsLine(line_addr_t lineAddr);
+        bool invalidateLine(line_addr_t lineAddr);
+
+        // sets with more ways than this use the flat FullyAssocLRU engine
+        static const size_t FA_ENGINE_MIN_WAYS = 64;
 
 
     protected:
         std::vector<std::vector<map_t>>  maps;   // 2-D vector of maps
         std::vector<std::vector<list_t>> lists;  // 2-D vector of lists
+        std::vector<FullyAssocLRU> faSets;  // [bank * nSetsPerBank + set]
 
+        void simulateCold(const uintptr_t *addrs, const uint8_t *isWrites,
+                size_t begin, size_t end, std::vector<size_t> &unconverged);
+        void adoptConverged(LRUSimpleCache &cold);
 };
 
+/*
+ * Without an explicit timestamp, accesses are stamped from the bank clock
+ * (if set), or else arrive one per cycle. Only bank queueing uses the time.
+ */
+inline void LRUSimpleCache::access(uintptr_t addr, bool isWrite) {
+    access(addr, isWrite, bankClock != nullptr ? *bankClock : nAccesses);
+}
+
 class Network {
     public:
         Network();
         Network(int ourGlobalRank);
+        Network(int ourGlobalRank, int worldSize);
         void setOurGlobalRank(int ourGlobalRank);
-        void sendTo(int destID, size_t nBytes);
+        int getOurGlobalRank();
+        void setTopology(const Topology *topology);
+        inline void sendTo(int destID, size_t nBytes);
+        inline void sendTo(int destID, size_t nBytes, uint64_t timestamp);
+        void sendToBatch(const int *destIDs, const size_t *nBytes, size_t n);
+        void receiveFrom(int srcID, size_t nBytes);
+        void enableTimeWindows(uint64_t windowLength);
+        void setWindowClock(const uint64_t *clock);
+        void enableTimingModel(double linkBytesPerCycle, uint64_t hopLatency,
+                uint64_t injectionOverhead = 0);
         void zeroStatsCounters();
+        size_t getNDests();
+        size_t getBytesTo(int destID);
+        size_t getMsgsTo(int destID);
+        size_t getBytesFrom(int srcID);
+        const Histogram &getMsgSizeHistogram();
+        const std::vector<size_t> &getLinkBytes();
+        size_t getByteHops();
+        const Histogram &getLatencyHistogram();
+        const Histogram &getQueueingHistogram();
+        size_t getNUntimedMsgs();
+        uint32_t getInjectionLink();
+        double getLinkUtilization(uint32_t link, uint64_t window);
         void dumpTextStats(FILE * const outputFile);
         void dumpTextStats(const char * const outputFilepath);
+        void dumpTimeSeries(const char * const outputFilepath);
+        void dumpLinkUtilization(const char * const outputFilepath);
 
     private:
+        typedef struct {
+            size_t nBytes;
+            size_t nMsgs;
+        } dest_counters_t;
+
         int ourGlobalRank;
-        std::unordered_map<int, size_t> destBytes;
+        // dense, indexed by destination rank; grows if a rank is out of range
+        std::vector<dest_counters_t, AlignedAllocator<dest_counters_t>> dests;
+        // the same, for messages others sent us (only via receiveFrom())
+        std::vector<dest_counters_t> srcs;
+        Histogram msgSizes;
+
+        // optional physical topology (not owned; may be shared across ranks)
+        const Topology *topology;
+        std::vector<size_t> linkBytes;      // [link ID]
+        size_t byteHops;
+        std::vector<uint32_t> route;        // scratch, to avoid reallocating
+
+        // optional time-windowed traffic matrix: windows[w][dest] holds the
+        // bytes sent during [w * windowLength, (w+1) * windowLength); only
+        // windows with traffic are kept, so timestamps can be sparse
+        uint64_t windowLength;              // 0 if disabled
+        const uint64_t *windowClock;        // e.g. a cache's access counter
+        uint64_t curWindow;
+        std::map<uint64_t, std::vector<size_t>> windows;
+        std::vector<size_t> *curWindowBytes;
+
+        // optional latency/bandwidth model: links are topology links, plus
+        // our injection link (ID getInjectionLink()) ahead of them
+        bool timingEnabled;
+        double cyclesPerByte;
+        uint64_t hopLatency, injectionOverhead;
+        std::vector<uint64_t> linkBusyUntil;    // [link ID]
+        Histogram latencies, queueingDelays;
+        size_t nUntimedMsgs;                // sent with nothing to time them
+        // busy cycles per link, in the same windows as the traffic matrix:
+        // linkBusy[w][link]; only windows with busy links are kept
+        std::map<uint64_t, std::vector<uint64_t>> linkBusy;
+
+        void growDests(int destID);
+        void routeSend(int destID, size_t nBytes);
+        void resetTimingModel();
+        void timeSend(size_t nBytes, uint64_t timestamp);
+        void addLinkBusy(uint32_t link, uint64_t start, uint64_t nCycles);
+        void switchWindow(uint64_t window);
+        inline void recordWindow(int destID, size_t nBytes, uint64_t timestamp);
+        inline void send(int destID, size_t nBytes, uint64_t timestamp,
+                bool hasTimestamp);
 };
 
+/*
+ * Without an explicit timestamp, sends are stamped from the window clock (if
+ * set). Failing that, windowed sends all land in window 0, and the timing
+ * model counts them (see getNUntimedMsgs()) instead of timing them, since
+ * timing them all at cycle 0 would just queue each behind all the others.
+ */
+inline void Network::sendTo(int destID, size_t nBytes) {
+    if (windowClock != nullptr) send(destID, nBytes, *windowClock, true);
+    else send(destID, nBytes, 0, false);
+}
+
+inline void Network::sendTo(int destID, size_t nBytes, uint64_t timestamp) {
+    send(destID, nBytes, timestamp, true);
+}
+
+inline void Network::send(int destID, size_t nBytes, uint64_t timestamp,
+        bool hasTimestamp) {
+    if (size_t(destID) >= dests.size()) growDests(destID);
+
+    dest_counters_t &d = dests[destID];
+    d.nBytes += nBytes;
+    ++d.nMsgs;
+    msgSizes.record(nBytes);
+
+    if (topology != nullptr) routeSend(destID, nBytes);
+    if (windowLength != 0) recordWindow(destID, nBytes, timestamp);
+    if (timingEnabled) {
+        if (hasTimestamp) timeSend(nBytes, timestamp);
+        else ++nUntimedMsgs;
+    }
+}
+
+inline void Network::recordWindow(int destID, size_t nBytes,
+        uint64_t timestamp) {
+    uint64_t window = timestamp / windowLength;
+    if (window != curWindow or curWindowBytes == nullptr) switchWindow(window);
+    if (size_t(destID) >= curWindowBytes->size()) {
+        curWindowBytes->resize(dests.size(), 0);
+    }
+    (*curWindowBytes)[destID] += nBytes;
+}
+
 
 class HistogramCounter {
     public:
@@ -124,37 +365,145 @@ class Cache {
             size_t nR, nW;
             double L1RHP, L2RHP, L2RMP;
             double L1WHP, L2WHP, L2WMP;
+            double L2BankImbalance;     // max/mean accesses per L2 bank
+
+            // 3C breakdown of L2RM/L2WM (only with enableMissClassification())
+            size_t L2RMByClass[N_MISS_CLASSES];
+            size_t L2WMByClass[N_MISS_CLASSES];
+
+            // timing (only with setLatencies())
+            size_t totalCycles, stallCycles;
+            double AMAT;
+
+            // non-blocking operation (only with enableMSHRs())
+            size_t elapsedCycles;
+            size_t L1SecondaryMisses, L2SecondaryMisses;
+            size_t memRequests;         // primary L2 misses
+
+            // L2 bank contention (only with enableL2BankQueueing())
+            size_t L2BankConflicts, L2BankQueueingCycles;
+
+            // memory traffic (only with attachDRAM() or setMissTrace())
+            size_t memReads, memWritebacks;
         } stats_t;
 
         Cache(size_t L1NLines, size_t L1NWays, size_t L2NLines, size_t L2NWays,
-                size_t L2NBanks, size_t cacheLineNBytes);
+                size_t L2NBanks, size_t cacheLineNBytes,
+                bank_hash_t L2BankHash = BANK_HASH_FOLD);
         uint64_t getCacheLineSizeLog2();
         void computeStats();
         stats_t *getStats();
+        bool hasOptionalModels();
+        const std::vector<size_t> &getL2BankAccesses();
+        const uint64_t *getAccessCounter();
+        void enableMissClassification();
+        void enableNUCA(size_t gridWidth, size_t gridHeight,
+                uint32_t baseLatency, uint32_t hopLatency);
+        void setL2BankPosition(size_t bank, uint32_t x, uint32_t y);
+        void setCorePosition(int core, uint32_t x, uint32_t y);
+        void setCore(int core);
+        const Histogram &getL2HitLatencies(int core);
+        void setLatencies(uint32_t L1HitLatency, uint32_t L2HitLatency,
+                uint32_t memLatency);
+        const Histogram &getAccessLatencies();
+        void enableMSHRs(size_t L1NMSHRs, size_t L2NMSHRs,
+                uint32_t issueInterval = 1);
+        void enableL2BankQueueing(uint32_t serviceCycles,
+                const uint64_t *clock = nullptr);
+        const BankQueues *getL2BankQueues();
+        void attachDRAM(DRAM *dram);
+        void setMissTrace(MissTraceWriter *missTrace);
         void zeroStatsCounters();
         void dumpTextStats(FILE * const outputFile);
+        void dumpSetStats(const char * const outputFilepath);
 
 
     protected:
+        typedef struct {
+            uint32_t x, y;
+        } grid_pos_t;
+
         size_t L1NLines, L1NWays, L1NSets;
         size_t L2NLines, L2NWays, L2NSetsPerBank, L2NBanks;
         size_t cacheLineSizeLog2;
 
         // interior stats struct
         stats_t s;
+        uint64_t nAccesses;     // monotonic; not reset by zeroStatsCounters()
+
+        BankHasher L2BankHasher;
+        std::vector<size_t> L2BankAccesses;     // per-bank access histogram
+        std::vector<set_stats_t> L1SetStats;    // [set]
+        std::vector<set_stats_t> L2SetStats;    // [bank * L2NSetsPerBank + set]
+        std::unique_ptr<MissClassifier> L2Classifier;   // null if disabled
+
+        // optional NUCA model: L2 banks and cores sit on an on-chip grid,
+        // and an L2 hit costs baseLatency + hopLatency * (Manhattan distance)
+        bool NUCAEnabled;
+        size_t NUCAGridWidth, NUCAGridHeight;
+        uint32_t NUCABaseLatency, NUCAHopLatency;
+        std::vector<grid_pos_t> L2BankPositions;    // [bank]
+        std::vector<grid_pos_t> corePositions;      // [core]
+        std::vector<uint32_t> NUCALatency;          // [core * L2NBanks + bank]
+        std::vector<Histogram> L2HitLatencies;      // [core]
+        int curCore;
+        // L2 hits/misses not yet folded into the histograms (which happens
+        // whenever the latencies change, or stats are read), so that the
+        // hot path only bumps a counter: [core * L2NBanks + bank]
+        std::vector<uint64_t> NUCAHits, NUCAMisses;
+        Histogram NUCAAccessLatencies;  // of the L1 misses, folded so far
+
+        // optional timing model; derived from the counters by computeStats()
+        bool timingEnabled;
+        uint32_t L1HitLatency, L2HitLatency, memLatency;
+        Histogram accessLatencies;
+
+        // optional non-blocking model: accesses issue every issueInterval
+        // cycles (unless the L1 MSHRs are full), and misses overlap
+        std::unique_ptr<MSHRFile> L1MSHRs, L2MSHRs;     // null if disabled
+        uint32_t issueInterval;
+        uint64_t clock, statsStartCycle;
+        uint64_t lastDone;          // when the latest access completes
+        Histogram MSHRAccessLatencies;
+
+        // optional L2 bank contention model: L1 misses arrive at their L2
+        // bank at *L2BankClock, or one access per cycle without a clock (or
+        // as timed by the MSHR model, if enabled)
+        std::unique_ptr<BankQueues> L2BankQueues;   // null if disabled
+        const uint64_t *L2BankClock;
+
+        // optional DRAM behind the L2 and/or trace of what we'd send it
+        // (neither is owned): L2 misses, and the writebacks of L2 lines
+        // written while cached
+        DRAM *dram;                         // null if not attached
+        MissTraceWriter *missTrace;         // null if not tracing
+        bool forwardsMisses;                // either of the above
+        std::unordered_set<line_addr_t> dirtyLines;
 
         inline line_addr_t addrToLineAddr(intptr_t addr);
-        inline uint32_t fastHash(line_addr_t lineAddr, uint64_t maxSize);
         inline size_t lineToLXSet(line_addr_t lineAddr, size_t nSets);
         bool touchLine(line_addr_t lineAddr, map_t &map, list_t &list,
                 size_t nWays);
+        void updateNUCALatencies();
+        void foldNUCACounts();
+        void timeNonBlocking(line_addr_t line, size_t L2Bank, bool wasL1Hit,
+                bool wasL2Hit);
+        void memoryAccess(line_addr_t line, bool isWrite, bool wasL2Hit,
+                bool L2Evicted, line_addr_t L2Victim);
 };
 
 class LRUCache : public Cache {
     public:
         LRUCache(size_t L1NLines, size_t L1NWays, size_t L2NLines,
-                size_t L2NWays, size_t L2NBanks, size_t cacheLineNBytes);
+                size_t L2NWays, size_t L2NBanks, size_t cacheLineNBytes,
+                bank_hash_t L2BankHash = BANK_HASH_FOLD);
         void access(uintptr_t addr, bool isWrite);
+        void accessBatch(const uintptr_t *addrs, const uint8_t *isWrites,
+                size_t n);
+        void replayL1Filtered(const L1Filter &filter);
+        void accessBatchPipelined(const uintptr_t *addrs,
+                const uint8_t *isWrites, size_t n,
+                size_t ringNRecords = 4096);
 
 
     protected:
@@ -162,4 +511,15 @@ class LRUCache : public Cache {
         std::vector<list_t> L1Lists;               // 1-D vector of lists
         std::vector<std::vector<map_t>>  L2Maps;   // 2-D vector of maps
         std::vector<std::vector<list_t>> L2Lists;  // 2-D vector of lists
+
+        // what the L1 stage passes on in pipelined mode
+        typedef struct {
+            line_addr_t line;
+            uint8_t isWrite, wasL1Hit, L1Evicted;
+        } l2_request_t;
+
+        inline bool accessL1(line_addr_t lineAddr, bool &L1Evicted);
+        inline void accessL2(line_addr_t lineAddr, bool isWrite,
+                bool wasL1Hit, bool L1Evicted);
+        void repeatHits(line_addr_t lineAddr, size_t nReads, size_t nWrites);
 };
@@ -0,0 +1,201 @@
+/*
+ * Implementation of the DRAM model (see DRAM.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "DRAM.h"
+
+
+DRAM::DRAM(const dram_config_t &config) {
+    assert(config.nChannels > 0 and config.nRanksPerChannel > 0);
+    assert(config.nBanksPerRank > 0 and config.queueDepth > 0);
+    assert(config.rowNBytes % config.cacheLineNBytes == 0);
+    this->config = config;
+    this->linesPerRow = config.rowNBytes / config.cacheLineNBytes;
+
+    channels.resize(config.nChannels);
+    for (channel_t &ch : channels) {
+        ch.pending.reserve(config.queueDepth);
+        ch.banks = std::vector<bank_t>(
+                config.nRanksPerChannel * config.nBanksPerRank,
+                bank_t{ NO_ROW, 0 });
+        ch.now = 0;
+        ch.busFreeAt = 0;
+    }
+    clearStats();
+}
+
+/*
+ * Roughly DDR4-3200 with two channels, timings in memory-bus cycles.
+ */
+dram_config_t DRAM::defaultConfig() {
+    dram_config_t config;
+    config.nChannels = 2;
+    config.nRanksPerChannel = 2;
+    config.nBanksPerRank = 16;
+    config.rowNBytes = 8192;
+    config.cacheLineNBytes = 64;
+    config.pagePolicy = DRAM_OPEN_PAGE;
+    config.tCAS = 22;
+    config.tRCD = 22;
+    config.tRP = 22;
+    config.tBurst = 4;
+    config.queueDepth = 32;
+    return config;
+}
+
+/*
+ * Queues a read (cache fill) or write (writeback) of lineAddr arriving at
+ * cycle timestamp; it's scheduled once its channel's queue fills up, or on
+ * flush().
+ */
+void DRAM::request(uint64_t lineAddr, bool isWrite, uint64_t timestamp) {
+    channel_t &ch = channels[lineAddr % config.nChannels];
+    uint64_t rest = lineAddr / config.nChannels / linesPerRow;
+    uint32_t bank = rest % config.nBanksPerRank;
+    rest /= config.nBanksPerRank;
+    bank += (rest % config.nRanksPerChannel) * config.nBanksPerRank;
+    uint64_t row = rest / config.nRanksPerChannel;
+
+    isWrite ? ++s.nWrites : ++s.nReads;
+    firstArrival = std::min(firstArrival, timestamp);
+
+    if (ch.pending.size() == config.queueDepth) issue(ch);
+    ch.pending.push_back(request_t{ lineAddr, timestamp, row, bank, isWrite });
+}
+
+/*
+ * Schedules every queued request.
+ */
+void DRAM::flush() {
+    for (channel_t &ch : channels) {
+        while (!ch.pending.empty()) issue(ch);
+    }
+}
+
+/*
+ * Schedules one of channel's queued requests, FR-FCFS.
+ */
+void DRAM::issue(channel_t &ch) {
+    uint64_t oldest = ch.pending[0].arrival;
+    for (const request_t &r : ch.pending) oldest = std::min(oldest, r.arrival);
+    uint64_t now = std::max(ch.now, oldest);
+
+    // first ready: the oldest arrived request to an open row, if any
+    size_t pick = 0;
+    for (size_t i = 0; i < ch.pending.size(); ++i) {
+        const request_t &r = ch.pending[i];
+        if (r.arrival <= now and ch.banks[r.bank].openRow == r.row) {
+            pick = i;
+            break;
+        }
+    }
+    request_t r = ch.pending[pick];
+    ch.pending.erase(ch.pending.begin() + pick);
+    bank_t &bank = ch.banks[r.bank];
+
+    uint64_t start = std::max(now, r.arrival);
+    if (bank.readyAt > start) {
+        ++s.nBankBusyWaits;
+        start = bank.readyAt;
+    }
+
+    uint64_t activate = 0;      // cycles before the column read
+    if (bank.openRow == r.row) {
+        ++s.nRowHits;
+    }
+    else if (bank.openRow == NO_ROW) {
+        ++s.nRowMisses;
+        activate = config.tRCD;
+    }
+    else {
+        ++s.nRowConflicts;
+        activate = config.tRP + config.tRCD;
+    }
+
+    uint64_t dataAt = std::max(start + activate + config.tCAS, ch.busFreeAt);
+    ch.busFreeAt = dataAt + config.tBurst;
+    ch.busBusyCycles += config.tBurst;
+    uint64_t done = dataAt + config.tBurst;
+
+    if (config.pagePolicy == DRAM_OPEN_PAGE) {
+        // later column reads to the row can follow a burst apart
+        bank.openRow = r.row;
+        bank.readyAt = start + activate + config.tBurst;
+    }
+    else {
+        bank.openRow = NO_ROW;
+        bank.readyAt = done + config.tRP;
+    }
+
+    ch.now = now + 1;   // one command per cycle
+    latencies.record(done - r.arrival);
+    lastDone = std::max(lastDone, done);
+}
+
+/*
+ * Zeroes the counters, leaving queued requests and bank state alone.
+ */
+void DRAM::clearStats() {
+    memset(&s, 0, sizeof(s));
+    latencies.clear();
+    for (channel_t &ch : channels) ch.busBusyCycles = 0;
+    firstArrival = UINT64_MAX;
+    lastDone = 0;
+}
+
+void DRAM::computeStats() {
+    size_t nScheduled = s.nRowHits + s.nRowMisses + s.nRowConflicts;
+    s.rowHitRate = nScheduled == 0 ? 0.0 :
+            double(s.nRowHits) / double(nScheduled);
+
+    s.busUtilization = 0.0;
+    s.bytesPerCycle = 0.0;
+    if (lastDone > firstArrival) {
+        double span = double(lastDone - firstArrival);
+        uint64_t busBusyCycles = 0;
+        for (const channel_t &ch : channels) busBusyCycles += ch.busBusyCycles;
+        s.busUtilization = double(busBusyCycles) /
+                (span * double(config.nChannels));
+        s.bytesPerCycle = double(nScheduled * config.cacheLineNBytes) / span;
+    }
+}
+
+/*
+ * Stats as of now; counts only scheduled requests, so flush() first.
+ */
+DRAM::stats_t *DRAM::getStats() {
+    computeStats();
+    return &s;
+}
+
+const Histogram &DRAM::getLatencies() {
+    return latencies;
+}
+
+const char *DRAM::name(dram_page_policy_t pagePolicy) {
+    return pagePolicy == DRAM_OPEN_PAGE ? "open-page" : "closed-page";
+}
+
+void DRAM::dumpTextStats(FILE * const f) {
+    flush();
+    computeStats();
+
+    fprintf(f, "------------ DRAM Statistics ------------\n");
+    fprintf(f, "DRAM: %u channels x %u ranks x %u banks, %u-byte rows, "
+            "%s\n", config.nChannels, config.nRanksPerChannel,
+            config.nBanksPerRank, config.rowNBytes, name(config.pagePolicy));
+    fprintf(f, "Reads: %zu    writes: %zu\n", s.nReads, s.nWrites);
+    fprintf(f, "Row hits: %zu (%.2f%%)    misses: %zu    conflicts: %zu    "
+            "bank busy waits: %zu\n", s.nRowHits, s.rowHitRate * 100,
+            s.nRowMisses, s.nRowConflicts, s.nBankBusyWaits);
+    fprintf(f, "Bus utilization: %.2f%%    bandwidth: %.2f bytes/cycle\n",
+            s.busUtilization * 100, s.bytesPerCycle);
+    latencies.dumpText(f, "DRAM latency (cycles) ");
+}
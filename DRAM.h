@@ -0,0 +1,98 @@
+/*
+ * Lightweight DRAM model for the memory behind a last-level cache.
+ *
+ * Lines are spread over channels, then ranks and banks, with consecutive
+ * lines on consecutive channels and a whole row's worth of lines per bank
+ * (row:rank:bank:column:channel address mapping). Each bank has a row
+ * buffer: an access to the open row only needs a column read (tCAS), one
+ * to a closed bank first activates the row (tRCD), and one to a different
+ * open row first precharges it (tRP). With the closed-page policy, banks
+ * precharge right after every access instead. Each channel's data bus takes
+ * tBurst cycles per line.
+ *
+ * Each channel's controller holds up to queueDepth requests and schedules
+ * them FR-FCFS: the oldest arrived request that hits an open row goes
+ * first, or else the oldest request. All times are in cycles, taken from
+ * the timestamps passed to request(); call flush() before reading stats.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "Histogram.h"
+
+typedef enum {
+    DRAM_OPEN_PAGE,     // leave rows open until another row is needed
+    DRAM_CLOSED_PAGE,   // precharge after every access
+} dram_page_policy_t;
+
+typedef struct {
+    uint32_t nChannels, nRanksPerChannel, nBanksPerRank;
+    uint32_t rowNBytes, cacheLineNBytes;
+    dram_page_policy_t pagePolicy;
+    uint32_t tCAS, tRCD, tRP, tBurst;
+    uint32_t queueDepth;            // per channel
+} dram_config_t;
+
+class DRAM {
+    public:
+        typedef struct {
+            size_t nReads, nWrites;
+            size_t nRowHits, nRowMisses;    // misses found the bank closed
+            size_t nRowConflicts;           // another row was open
+            size_t nBankBusyWaits;          // had to wait for the bank
+            double rowHitRate;
+            double busUtilization;          // over all channels
+            double bytesPerCycle;
+        } stats_t;
+
+        DRAM(const dram_config_t &config);
+        static dram_config_t defaultConfig();
+
+        void request(uint64_t lineAddr, bool isWrite, uint64_t timestamp);
+        void flush();
+        void clearStats();
+
+        stats_t *getStats();
+        const Histogram &getLatencies();
+        static const char *name(dram_page_policy_t pagePolicy);
+        void dumpTextStats(FILE * const outputFile);
+
+    private:
+        typedef struct {
+            uint64_t line;
+            uint64_t arrival;
+            uint64_t row;
+            uint32_t bank;      // rank * nBanksPerRank + bank
+            bool isWrite;
+        } request_t;
+
+        typedef struct {
+            uint64_t openRow;   // NO_ROW if precharged
+            uint64_t readyAt;
+        } bank_t;
+
+        typedef struct {
+            std::vector<request_t> pending;     // in request() order
+            std::vector<bank_t> banks;
+            uint64_t now;                       // controller's clock
+            uint64_t busFreeAt;
+            uint64_t busBusyCycles;
+        } channel_t;
+
+        static const uint64_t NO_ROW = UINT64_MAX;
+
+        dram_config_t config;
+        uint64_t linesPerRow;
+        std::vector<channel_t> channels;
+
+        stats_t s;
+        Histogram latencies;    // arrival to last byte, per request
+        uint64_t firstArrival, lastDone;
+
+        void issue(channel_t &channel);
+        void computeStats();
+};
@@ -0,0 +1,197 @@
+/*
+ * Implementation of the coherence directory (see Directory.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Directory.h"
+
+
+Directory::Directory(size_t nNodes, const HomeMap *homeMap, size_t nLines,
+        size_t nWays, size_t cacheLineNBytes, size_t controlNBytes) {
+    assert(nNodes > 0);
+    this->nNodes = nNodes;
+    this->nodesPerBit = (nNodes + 63) / 64;
+    this->cacheLineSizeLog2 = log2(cacheLineNBytes);
+    this->lineNBytes = cacheLineNBytes;
+    this->controlNBytes = controlNBytes;
+    this->homeMap = homeMap;
+
+    caches.reserve(nNodes);
+    networks.reserve(nNodes);
+    for (size_t node = 0; node < nNodes; ++node) {
+        caches.emplace_back(new LRUSimpleCache(nLines, nWays, 1,
+                cacheLineNBytes, false));
+        caches.back()->attachDirectory(this, node);
+        networks.emplace_back(node, nNodes);
+    }
+    shards.resize(nNodes);
+
+    memset(&s, 0, sizeof(s));
+}
+
+/*
+ * Runs node's access through the protocol (sending whatever messages it
+ * takes to get the line in the right state), then through node's cache.
+ */
+void Directory::access(int node, uintptr_t addr, bool isWrite) {
+    line_addr_t line = addr >> cacheLineSizeLog2;
+    int home = homeOf(line);
+    assert(size_t(home) < nNodes);
+
+    auto &shard = shards[home];
+    bool cached = caches[node]->containsLine(line);
+
+    if (!isWrite) {
+        if (!cached) {
+            ++s.nRequests;
+            send(node, home, controlNBytes);
+
+            auto inserted = shard.emplace(line, entry_t{ 0, 0, -1 });
+            entry_t &e = inserted.first->second;
+            if (e.owner >= 0) {     // the owner sends the data, keeps a copy
+                ++s.nForwards;
+                ++s.nWritebacks;
+                send(home, e.owner, controlNBytes);
+                send(e.owner, node, lineNBytes);
+                send(e.owner, home, lineNBytes);
+                e.owner = -1;
+            }
+            else {
+                send(home, node, lineNBytes);
+            }
+            e.sharers |= sharerBit(node);
+            ++e.nSharers;
+        }
+    }
+    else {
+        auto it = shard.find(line);
+        if (!(cached and it != shard.end() and it->second.owner == node)) {
+            cached ? ++s.nUpgrades : ++s.nRequests;
+            send(node, home, controlNBytes);
+
+            auto inserted = shard.emplace(line, entry_t{ 0, 0, -1 });
+            entry_t &e = inserted.first->second;
+            if (e.owner >= 0) {     // the owner sends the data, and drops it
+                ++s.nForwards;
+                ++s.nInvalidations;
+                send(home, e.owner, controlNBytes);
+                send(e.owner, node, lineNBytes);
+                caches[e.owner]->invalidateLine(line);
+            }
+            else {
+                invalidateSharers(e, line, home, node);
+                send(home, node, cached ? controlNBytes : lineNBytes);
+            }
+            e.sharers = sharerBit(node);
+            e.nSharers = 1;
+            e.owner = node;
+        }
+    }
+
+    // may call evicted() on the victim, so no entry references past here
+    caches[node]->access(addr, isWrite);
+}
+
+/*
+ * Invalidates every (possible) sharer but requester; each acks the
+ * requester. With coarse vectors, some of them won't have the line.
+ */
+void Directory::invalidateSharers(entry_t &e, line_addr_t line, int home,
+        int requester) {
+    uint64_t sharers = e.sharers;
+    while (sharers != 0) {
+        size_t bit = __builtin_ctzll(sharers);
+        sharers &= sharers - 1;
+
+        size_t first = bit * nodesPerBit;
+        size_t last = std::min(first + nodesPerBit, nNodes);
+        for (size_t n = first; n < last; ++n) {
+            if (int(n) == requester) continue;
+            ++s.nInvalidations;
+            send(home, n, controlNBytes);
+            send(n, requester, controlNBytes);
+            if (!caches[n]->invalidateLine(line)) ++s.nSpuriousInvalidations;
+        }
+    }
+}
+
+/*
+ * Called by node's cache when it evicts line: dirty lines are written back,
+ * and clean ones are reported with a replacement hint, so that the entry can
+ * be freed once nobody caches the line.
+ */
+void Directory::evicted(int node, line_addr_t line) {
+    int home = homeOf(line);
+    auto &shard = shards[home];
+    auto it = shard.find(line);
+    assert(it != shard.end());
+    entry_t &e = it->second;
+
+    if (e.owner == node) {
+        ++s.nWritebacks;
+        send(node, home, lineNBytes);
+        shard.erase(it);
+        return;
+    }
+
+    ++s.nReplacementHints;
+    send(node, home, controlNBytes);
+    // a coarse bit may cover other sharers; it goes stale until freed
+    if (nodesPerBit == 1) e.sharers &= ~sharerBit(node);
+    if (--e.nSharers == 0) shard.erase(it);
+}
+
+LRUSimpleCache &Directory::getCache(int node) {
+    return *caches[node];
+}
+
+Network &Directory::getNetwork(int node) {
+    return networks[node];
+}
+
+size_t Directory::getNEntries() {
+    size_t nEntries = 0;
+    for (auto &shard : shards) nEntries += shard.size();
+    return nEntries;
+}
+
+size_t Directory::getNSharers(uintptr_t addr) {
+    line_addr_t line = addr >> cacheLineSizeLog2;
+    auto &shard = shards[homeOf(line)];
+    auto it = shard.find(line);
+    return it == shard.end() ? 0 : it->second.nSharers;
+}
+
+int Directory::getOwner(uintptr_t addr) {
+    line_addr_t line = addr >> cacheLineSizeLog2;
+    auto &shard = shards[homeOf(line)];
+    auto it = shard.find(line);
+    return it == shard.end() ? -1 : it->second.owner;
+}
+
+Directory::stats_t *Directory::getStats() {
+    return &s;
+}
+
+void Directory::dumpTextStats(FILE * const f) {
+    fprintf(f, "------------ Directory Statistics ------------\n");
+    fprintf(f, "NODES\t%zu (%zu per sharer bit)\n", nNodes, nodesPerBit);
+    fprintf(f, "HOME_MAP\t%s\n", HomeMap::name(homeMap->getKind()));
+    fprintf(f, "ENTRIES\t%zu\n", getNEntries());
+    fprintf(f, "REQUESTS\t%zu\n", s.nRequests);
+    fprintf(f, "UPGRADES\t%zu\n", s.nUpgrades);
+    fprintf(f, "FORWARDS\t%zu\n", s.nForwards);
+    fprintf(f, "INVALIDATIONS\t%zu (%zu spurious)\n", s.nInvalidations,
+            s.nSpuriousInvalidations);
+    fprintf(f, "WRITEBACKS\t%zu\n", s.nWritebacks);
+    fprintf(f, "REPLACEMENT_HINTS\t%zu\n", s.nReplacementHints);
+}
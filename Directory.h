@@ -0,0 +1,93 @@
+/*
+ * Directory-based (MSI) coherence across simulated nodes in one process.
+ *
+ * Every node gets its own LRUSimpleCache and Network. Each line's home node
+ * (per a HomeMap) keeps that line's directory entry in its own shard, only
+ * while some node caches the line, so memory grows with the cached lines
+ * rather than with the address space. An entry holds a 64-bit sharer vector:
+ * one bit per node up to 64 nodes, and beyond that one bit per group of
+ * ceil(nNodes / 64) nodes (a coarse vector), whose invalidations go to the
+ * whole group. An exact sharer count lets entries be freed either way.
+ *
+ * Requests, data, forwards, invalidations (and their acks), writebacks and
+ * replacement hints all go into the sending node's Network; messages between
+ * a node and itself are free.
+ */
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Cache.h"
+#include "HomeMap.h"
+
+class Directory {
+    public:
+        typedef struct {
+            size_t nRequests;           // read/write misses sent home
+            size_t nUpgrades;           // writes to lines held shared
+            size_t nForwards;           // requests forwarded to an owner
+            size_t nInvalidations;
+            size_t nSpuriousInvalidations;  // coarse-vector misfires
+            size_t nWritebacks;         // dirty data sent home
+            size_t nReplacementHints;   // clean evictions reported home
+        } stats_t;
+
+        Directory(size_t nNodes, const HomeMap *homeMap, size_t nLines,
+                size_t nWays, size_t cacheLineNBytes,
+                size_t controlNBytes = 8);
+        Directory(const Directory &) = delete;
+        Directory &operator=(const Directory &) = delete;
+
+        void access(int node, uintptr_t addr, bool isWrite);
+        void evicted(int node, line_addr_t line);
+
+        LRUSimpleCache &getCache(int node);
+        Network &getNetwork(int node);
+        size_t getNEntries();
+        size_t getNSharers(uintptr_t addr);
+        int getOwner(uintptr_t addr);
+        stats_t *getStats();
+        void dumpTextStats(FILE * const outputFile);
+
+    private:
+        typedef struct {
+            uint64_t sharers;       // bit per node (or per group of nodes)
+            uint32_t nSharers;      // exact
+            int32_t owner;          // holds the line modified; -1 if none
+        } entry_t;
+
+        size_t nNodes;
+        size_t nodesPerBit;
+        size_t cacheLineSizeLog2;
+        size_t lineNBytes, controlNBytes;
+        const HomeMap *homeMap;
+
+        std::vector<std::unique_ptr<LRUSimpleCache>> caches;   // [node]
+        std::vector<Network> networks;                          // [node]
+        std::vector<std::unordered_map<line_addr_t, entry_t>> shards; // [home]
+        stats_t s;
+
+        inline uint64_t sharerBit(int node) const;
+        inline int homeOf(line_addr_t line) const;
+        inline void send(int from, int to, size_t nBytes);
+        void invalidateSharers(entry_t &e, line_addr_t line, int home,
+                int requester);
+};
+
+
+inline uint64_t Directory::sharerBit(int node) const {
+    return uint64_t(1) << (node / nodesPerBit);
+}
+
+inline int Directory::homeOf(line_addr_t line) const {
+    return homeMap->home(line << cacheLineSizeLog2);
+}
+
+inline void Directory::send(int from, int to, size_t nBytes) {
+    if (from != to) networks[from].sendTo(to, nBytes);
+}
@@ -0,0 +1,128 @@
+/*
+ * Implementation of the radix-bitmap footprint tracker (see FootprintBitmap.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "FootprintBitmap.h"
+
+
+FootprintBitmap::FootprintBitmap(size_t cacheLineSizeLog2) {
+    this->cacheLineSizeLog2 = cacheLineSizeLog2;
+    clear();
+}
+
+/*
+ * Returns the leaf for leafKey, allocating it (and its mid level) if needed.
+ */
+uint64_t *FootprintBitmap::getLeaf(uint64_t leafKey) {
+    auto &mid = top[leafKey >> MID_BITS];
+    if (!mid) mid.reset(new mid_t());
+
+    auto &leaf = mid->leaves[leafKey & (MID_FANOUT - 1)];
+    if (!leaf) leaf.reset(new uint64_t[LEAF_WORDS]());
+
+    return leaf.get();
+}
+
+/*
+ * Returns the leaf for leafKey, or null if it was never allocated.
+ */
+const uint64_t *FootprintBitmap::findLeaf(uint64_t leafKey) const {
+    auto it = top.find(leafKey >> MID_BITS);
+    if (it == top.end()) return nullptr;
+    return it->second->leaves[leafKey & (MID_FANOUT - 1)].get();
+}
+
+bool FootprintBitmap::contains(uint64_t lineAddr) const {
+    const uint64_t *leaf = findLeaf(lineAddr >> LEAF_BITS);
+    if (leaf == nullptr) return false;
+
+    uint64_t word = leaf[(lineAddr >> 6) & (LEAF_WORDS - 1)];
+    return (word >> (lineAddr & 63)) & 1;
+}
+
+size_t FootprintBitmap::getNLinesTouched() const {
+    return nLinesTouched;
+}
+
+/*
+ * Returns the number of distinct granuleNBytes-sized, -aligned regions (e.g.,
+ * lines, 4KiB pages, 2MiB huge pages) that contain at least one touched line.
+ * granuleNBytes must be a power of 2, and at least one line.
+ */
+size_t FootprintBitmap::footprint(size_t granuleNBytes) const {
+    assert((granuleNBytes & (granuleNBytes - 1)) == 0);
+    assert(granuleNBytes >= (size_t(1) << cacheLineSizeLog2));
+
+    size_t granuleLog2 = 0;     // in lines
+    while ((size_t(1) << (granuleLog2 + cacheLineSizeLog2)) < granuleNBytes)
+        ++granuleLog2;
+
+    if (granuleLog2 == 0) return nLinesTouched;
+
+    // granules at least as big as a leaf: count distinct granules over leaves
+    // (every allocated leaf has at least one bit set)
+    if (granuleLog2 >= LEAF_BITS) {
+        std::vector<uint64_t> granules;
+        for (auto &kv : top) {
+            for (size_t m = 0; m < MID_FANOUT; ++m) {
+                if (!kv.second->leaves[m]) continue;
+                uint64_t leafKey = (kv.first << MID_BITS) | m;
+                granules.push_back(leafKey >> (granuleLog2 - LEAF_BITS));
+            }
+        }
+        std::sort(granules.begin(), granules.end());
+        return std::unique(granules.begin(), granules.end()) -
+                granules.begin();
+    }
+
+    size_t count = 0;
+    for (auto &kv : top) {
+        for (size_t m = 0; m < MID_FANOUT; ++m) {
+            const uint64_t *leaf = kv.second->leaves[m].get();
+            if (leaf == nullptr) continue;
+
+            if (granuleLog2 >= 6) {     // granule spans whole words
+                size_t wordsPerGranule = size_t(1) << (granuleLog2 - 6);
+                for (size_t w = 0; w < LEAF_WORDS; w += wordsPerGranule) {
+                    uint64_t any = 0;
+                    for (size_t i = 0; i < wordsPerGranule; ++i)
+                        any |= leaf[w + i];
+                    count += any != 0;
+                }
+            }
+            else {  // several granules per word: OR each granule into its LSB
+                uint64_t lsbMask = 0;
+                for (size_t b = 0; b < 64; b += size_t(1) << granuleLog2)
+                    lsbMask |= uint64_t(1) << b;
+                for (size_t w = 0; w < LEAF_WORDS; ++w) {
+                    uint64_t word = leaf[w];
+                    for (size_t sh = 1; sh < (size_t(1) << granuleLog2);
+                            sh <<= 1) {
+                        word |= word >> sh;
+                    }
+                    count += __builtin_popcountll(word & lsbMask);
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+size_t FootprintBitmap::footprintBytes(size_t granuleNBytes) const {
+    return footprint(granuleNBytes) * granuleNBytes;
+}
+
+void FootprintBitmap::clear() {
+    top.clear();
+    nLinesTouched = 0;
+    lastLeafKey = 0;
+    lastLeaf = nullptr;
+}
@@ -0,0 +1,75 @@
+/*
+ * Compact first-touch and footprint tracker: one bit per line.
+ *
+ * Line addresses are split into three radix levels:
+ *   [ top: line >> 20 | mid: 8 bits | leaf: 12 bits ]
+ * Leaves are 512B bitmaps covering 2^12 lines (256KiB with 64B lines), and
+ * are only allocated once a line inside them is touched. The top level is a
+ * (small) hash map, so sparse and kernel-half addresses don't cost a huge
+ * pointer array. The most recently used leaf is cached, so a first-touch
+ * check is usually a compare, a load, and a test-and-set.
+ */
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+
+class FootprintBitmap {
+    public:
+        FootprintBitmap(size_t cacheLineSizeLog2 = 6);
+        inline bool touch(uint64_t lineAddr);
+        inline bool access(uintptr_t addr);
+        bool contains(uint64_t lineAddr) const;
+        size_t getNLinesTouched() const;
+        size_t footprint(size_t granuleNBytes) const;
+        size_t footprintBytes(size_t granuleNBytes) const;
+        void clear();
+
+    private:
+        static const uint32_t LEAF_BITS = 12;   // lines per leaf (log2)
+        static const uint32_t MID_BITS = 8;     // leaves per mid (log2)
+        static const size_t LEAF_WORDS = (size_t(1) << LEAF_BITS) / 64;
+        static const size_t MID_FANOUT = size_t(1) << MID_BITS;
+
+        typedef struct {
+            std::unique_ptr<uint64_t[]> leaves[MID_FANOUT];
+        } mid_t;
+
+        size_t cacheLineSizeLog2;
+        size_t nLinesTouched;
+        std::unordered_map<uint64_t, std::unique_ptr<mid_t>> top;
+
+        uint64_t lastLeafKey;           // lineAddr >> LEAF_BITS
+        uint64_t *lastLeaf;             // null if nothing cached
+
+        uint64_t *getLeaf(uint64_t leafKey);
+        const uint64_t *findLeaf(uint64_t leafKey) const;
+};
+
+
+/*
+ * Marks lineAddr as touched.
+ *
+ * Return value: whether/not this was the first touch of lineAddr.
+ */
+inline bool FootprintBitmap::touch(uint64_t lineAddr) {
+    uint64_t leafKey = lineAddr >> LEAF_BITS;
+    if (lastLeaf == nullptr or leafKey != lastLeafKey) {
+        lastLeaf = getLeaf(leafKey);
+        lastLeafKey = leafKey;
+    }
+
+    uint64_t &word = lastLeaf[(lineAddr >> 6) & (LEAF_WORDS - 1)];
+    uint64_t bit = uint64_t(1) << (lineAddr & 63);
+    bool first = (word & bit) == 0;
+    word |= bit;
+    nLinesTouched += first;
+
+    return first;
+}
+
+inline bool FootprintBitmap::access(uintptr_t addr) {
+    return touch(addr >> cacheLineSizeLog2);
+}
@@ -0,0 +1,49 @@
+/*
+ * Implementation of the O(1) fully-associative LRU cache (see FullyAssocLRU.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "FullyAssocLRU.h"
+
+// bound to const references (vector fill, std::fill), so it needs storage
+const uint32_t FullyAssocLRU::EMPTY;
+
+
+FullyAssocLRU::FullyAssocLRU(size_t capacity) {
+    assert(capacity > 0 and capacity < NIL);
+    this->capacity = capacity;
+
+    keys = std::vector<uint64_t>(capacity);
+    prev = std::vector<uint32_t>(capacity);
+    next = std::vector<uint32_t>(capacity);
+
+    // keep the index at most half full, so probe runs stay short
+    size_t indexSizeLog2 = 1;
+    while ((size_t(1) << indexSizeLog2) < 2 * capacity) ++indexSizeLog2;
+    index = std::vector<uint32_t>(size_t(1) << indexSizeLog2, EMPTY);
+    indexMask = (uint64_t(1) << indexSizeLog2) - 1;
+    indexShift = 64 - indexSizeLog2;
+
+    clear();
+}
+
+size_t FullyAssocLRU::size() const {
+    return nUsed - nFree;
+}
+
+size_t FullyAssocLRU::getCapacity() const {
+    return capacity;
+}
+
+void FullyAssocLRU::clear() {
+    nUsed = 0;
+    head = NIL;
+    tail = NIL;
+    freeList = NIL;
+    nFree = 0;
+    std::fill(index.begin(), index.end(), EMPTY);
+}
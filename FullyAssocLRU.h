@@ -0,0 +1,179 @@
+/*
+ * O(1) fully-associative LRU cache of line addresses.
+ *
+ * Lines live in flat, pre-sized arrays: an intrusive doubly linked list
+ * (prev/next node indices) keeps the LRU order, and an open-addressing index
+ * (linear probing, backward-shift deletion) maps a line to its node. Nothing
+ * is allocated or rehashed after construction, so this scales to millions of
+ * ways, unlike an unordered_map/list pair.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class FullyAssocLRU {
+    public:
+        FullyAssocLRU(size_t capacity);
+        inline bool touch(uint64_t line, bool allocate, bool &evicted,
+                uint64_t &evictedLine);
+        inline bool touch(uint64_t line);
+        inline bool contains(uint64_t line) const;
+        inline bool erase(uint64_t line);
+        size_t size() const;
+        size_t getCapacity() const;
+        void clear();
+
+    private:
+        static const uint32_t NIL = UINT32_MAX;
+        static const uint32_t EMPTY = 0;    // index slots hold node + 1
+
+        size_t capacity;
+        uint32_t nUsed;                     // nodes handed out so far
+        uint32_t head, tail;                // LRU, MRU
+        uint32_t freeList, nFree;           // erased nodes, linked by next[]
+
+        std::vector<uint64_t> keys;         // [node]
+        std::vector<uint32_t> prev, next;   // [node]
+
+        std::vector<uint32_t> index;        // [slot] => node + 1
+        uint64_t indexMask;
+        uint32_t indexShift;
+
+        inline uint64_t slotOf(uint64_t line) const;
+        inline uint64_t findSlot(uint64_t line) const;
+        inline void indexInsert(uint64_t line, uint32_t node);
+        inline void indexErase(uint64_t slot);
+        inline void unlink(uint32_t node);
+        inline void append(uint32_t node);
+};
+
+
+inline uint64_t FullyAssocLRU::slotOf(uint64_t line) const {
+    return (line * 0x9e3779b97f4a7c15ULL) >> indexShift;
+}
+
+/*
+ * Returns the slot holding line, or the empty slot where it would go.
+ */
+inline uint64_t FullyAssocLRU::findSlot(uint64_t line) const {
+    uint64_t slot = slotOf(line);
+    while (index[slot] != EMPTY and keys[index[slot] - 1] != line) {
+        slot = (slot + 1) & indexMask;
+    }
+    return slot;
+}
+
+inline void FullyAssocLRU::indexInsert(uint64_t line, uint32_t node) {
+    index[findSlot(line)] = node + 1;
+}
+
+/*
+ * Backward-shift deletion: pull later members of the probe run into the hole
+ * so that lookups never need tombstones.
+ */
+inline void FullyAssocLRU::indexErase(uint64_t slot) {
+    uint64_t hole = slot;
+    uint64_t cur = (slot + 1) & indexMask;
+    while (index[cur] != EMPTY) {
+        uint64_t home = slotOf(keys[index[cur] - 1]);
+        // move cur into the hole unless its home lies in (hole, cur]
+        if (((cur - home) & indexMask) >= ((cur - hole) & indexMask)) {
+            index[hole] = index[cur];
+            hole = cur;
+        }
+        cur = (cur + 1) & indexMask;
+    }
+    index[hole] = EMPTY;
+}
+
+inline void FullyAssocLRU::unlink(uint32_t node) {
+    uint32_t p = prev[node], n = next[node];
+    if (p != NIL) next[p] = n;
+    else          head = n;
+    if (n != NIL) prev[n] = p;
+    else          tail = p;
+}
+
+inline void FullyAssocLRU::append(uint32_t node) {
+    prev[node] = tail;
+    next[node] = NIL;
+    if (tail != NIL) next[tail] = node;
+    else             head = node;
+    tail = node;
+}
+
+inline bool FullyAssocLRU::contains(uint64_t line) const {
+    return index[findSlot(line)] != EMPTY;
+}
+
+/*
+ * "Touches" line: on a hit, moves it to MRU. On a miss, inserts it at MRU if
+ * allocate is set, evicting the LRU line when full.
+ *
+ * Return value: whether/not the touch action was a hit.
+ */
+inline bool FullyAssocLRU::touch(uint64_t line, bool allocate, bool &evicted,
+        uint64_t &evictedLine) {
+    evicted = false;
+
+    uint64_t slot = findSlot(line);
+    if (index[slot] != EMPTY) {
+        uint32_t node = index[slot] - 1;
+        if (node != tail) {
+            unlink(node);
+            append(node);
+        }
+        return true;
+    }
+
+    if (!allocate) return false;
+
+    uint32_t node;
+    if (freeList != NIL) {
+        node = freeList;
+        freeList = next[node];
+        --nFree;
+    }
+    else if (nUsed < capacity) {
+        node = nUsed++;
+    }
+    else {  // recycle the LRU node
+        node = head;
+        evicted = true;
+        evictedLine = keys[node];
+        unlink(node);
+        indexErase(findSlot(evictedLine));
+    }
+
+    keys[node] = line;
+    append(node);
+    indexInsert(line, node);
+
+    return false;
+}
+
+inline bool FullyAssocLRU::touch(uint64_t line) {
+    bool evicted;
+    uint64_t evictedLine;
+    return touch(line, true, evicted, evictedLine);
+}
+
+/*
+ * Removes line (e.g., on a coherence invalidation), if present.
+ *
+ * Return value: whether/not line was present.
+ */
+inline bool FullyAssocLRU::erase(uint64_t line) {
+    uint64_t slot = findSlot(line);
+    if (index[slot] == EMPTY) return false;
+
+    uint32_t node = index[slot] - 1;
+    unlink(node);
+    indexErase(slot);
+    next[node] = freeList;
+    freeList = node;
+    ++nFree;
+    return true;
+}
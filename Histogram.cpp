@@ -0,0 +1,103 @@
+/*
+ * Implementation of the log-linear histogram (see Histogram.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "Histogram.h"
+
+
+Histogram::Histogram(uint32_t subBucketBits) {
+    assert(subBucketBits < 16);
+    this->subBucketBits = subBucketBits;
+    buckets = std::vector<uint64_t>(size_t(64 - subBucketBits + 1) <<
+            subBucketBits, 0);
+    clear();
+}
+
+uint64_t Histogram::bucketLowerBound(size_t bucket) const {
+    if (bucket < (size_t(1) << subBucketBits)) return bucket;
+
+    uint32_t shift = (bucket >> subBucketBits) - 1;
+    uint64_t subBucket = bucket & ((size_t(1) << subBucketBits) - 1);
+    return ((uint64_t(1) << subBucketBits) + subBucket) << shift;
+}
+
+/*
+ * Adds other's samples to ours. Both must use the same subBucketBits.
+ */
+void Histogram::merge(const Histogram &other) {
+    assert(other.subBucketBits == subBucketBits);
+    for (size_t b = 0; b < buckets.size(); ++b) buckets[b] += other.buckets[b];
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+void Histogram::clear() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+uint64_t Histogram::getCount() const {
+    return count;
+}
+
+uint64_t Histogram::getSum() const {
+    return sum;
+}
+
+uint64_t Histogram::getMax() const {
+    return max;
+}
+
+double Histogram::getMean() const {
+    return count == 0 ? 0.0 : double(sum) / double(count);
+}
+
+/*
+ * Returns (the lower bound of the bucket holding) the p-th percentile sample,
+ * for p in [0, 100].
+ */
+uint64_t Histogram::percentile(double p) const {
+    if (count == 0) return 0;
+
+    uint64_t rank = (uint64_t) ceil(p / 100.0 * double(count));
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketLowerBound(b), max);
+    }
+    return max;
+}
+
+/*
+ * Prints a one-line summary, followed by every non-empty bucket. The last
+ * bucket's upper bound (2^64) doesn't fit, so it's printed as closed.
+ */
+void Histogram::dumpText(FILE * const f, const char * const prefix) const {
+    fprintf(f, "%s\tn: %zu  mean: %.2f  p50: %zu  p99: %zu  max: %zu\n",
+            prefix, (size_t) count, getMean(), (size_t) percentile(50),
+            (size_t) percentile(99), (size_t) max);
+
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b] == 0) continue;
+        if (b + 1 == buckets.size()) {
+            fprintf(f, "%s[%zu,%zu]\t%zu\n", prefix,
+                    (size_t) bucketLowerBound(b), (size_t) UINT64_MAX,
+                    (size_t) buckets[b]);
+            continue;
+        }
+        fprintf(f, "%s[%zu,%zu)\t%zu\n", prefix, (size_t) bucketLowerBound(b),
+                (size_t) bucketLowerBound(b + 1), (size_t) buckets[b]);
+    }
+}
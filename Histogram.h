@@ -0,0 +1,54 @@
+/*
+ * Log-linear histogram of non-negative integer samples (sizes, latencies).
+ *
+ * Values below 2^subBucketBits get exact buckets; above that, every power of
+ * 2 is split into 2^subBucketBits equal sub-buckets, so the relative error of
+ * a reported percentile is at most 2^-subBucketBits. Recording is a few
+ * shifts and an increment, with no allocation.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+class Histogram {
+    public:
+        Histogram(uint32_t subBucketBits = 3);
+        inline void record(uint64_t value, uint64_t count = 1);
+        void merge(const Histogram &other);
+        void clear();
+
+        uint64_t getCount() const;
+        uint64_t getSum() const;
+        uint64_t getMax() const;
+        double getMean() const;
+        uint64_t percentile(double p) const;
+        void dumpText(FILE * const f, const char * const prefix) const;
+
+    private:
+        uint32_t subBucketBits;
+        std::vector<uint64_t> buckets;
+        uint64_t count, sum, max;
+
+        inline size_t bucketOf(uint64_t value) const;
+        uint64_t bucketLowerBound(size_t bucket) const;
+};
+
+
+inline size_t Histogram::bucketOf(uint64_t value) const {
+    if (value < (uint64_t(1) << subBucketBits)) return value;
+
+    uint32_t log2 = 63 - __builtin_clzll(value);
+    uint32_t shift = log2 - subBucketBits;
+    uint64_t subBucket = (value >> shift) & ((uint64_t(1) << subBucketBits) - 1);
+    return (size_t(shift + 1) << subBucketBits) + subBucket;
+}
+
+inline void Histogram::record(uint64_t value, uint64_t count) {
+    buckets[bucketOf(value)] += count;
+    this->count += count;
+    this->sum += value * count;
+    if (value > max) max = value;
+}
@@ -0,0 +1,83 @@
+/*
+ * Implementation of the home-node mappings (see HomeMap.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "HomeMap.h"
+
+
+HomeMap::HomeMap(home_map_kind_t kind, size_t nRanks, size_t blockNBytes,
+        uintptr_t baseAddr, int defaultRank) {
+    this->kind = kind;
+    this->nRanks = nRanks;
+    this->blockNBytes = blockNBytes;
+    this->blockNBytesLog2 = __builtin_ctzll(blockNBytes);
+    this->baseAddr = baseAddr;
+    this->defaultRank = defaultRank;
+}
+
+/*
+ * Splits the array starting at baseAddr into blockNBytes blocks, and gives
+ * block i to rank i % nRanks. Addresses below baseAddr aren't supported.
+ */
+HomeMap HomeMap::blockCyclic(size_t nRanks, size_t blockNBytes,
+        uintptr_t baseAddr) {
+    assert(nRanks > 0 and blockNBytes > 0);
+    return HomeMap(HOME_BLOCK_CYCLIC, nRanks, blockNBytes, baseAddr, 0);
+}
+
+HomeMap HomeMap::pageInterleaved(size_t nRanks, size_t pageNBytes) {
+    assert(nRanks > 0);
+    assert(pageNBytes > 0 and (pageNBytes & (pageNBytes - 1)) == 0);
+    return HomeMap(HOME_PAGE_INTERLEAVED, nRanks, pageNBytes, 0, 0);
+}
+
+/*
+ * Starts an empty range table; fill it in with addRange(). Addresses outside
+ * every range live on defaultRank.
+ */
+HomeMap HomeMap::rangeTable(int defaultRank) {
+    return HomeMap(HOME_RANGE_TABLE, 0, 1, 0, defaultRank);
+}
+
+void HomeMap::addRange(uintptr_t start, uintptr_t end, int rank) {
+    assert(kind == HOME_RANGE_TABLE);
+    assert(start < end and rank >= 0);
+
+    range_t r = { start, end, rank };
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), r,
+            [](const range_t &a, const range_t &b) {
+                return a.start < b.start;
+            });
+    assert(it == ranges.end() or end <= it->start);
+    assert(it == ranges.begin() or std::prev(it)->end <= start);
+    ranges.insert(it, r);
+}
+
+int HomeMap::rangeHome(uintptr_t addr) const {
+    // find the last range starting at or below addr
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), addr,
+            [](uintptr_t a, const range_t &r) {
+                return a < r.start;
+            });
+    if (it == ranges.begin()) return defaultRank;
+    --it;
+    return addr < it->end ? it->rank : defaultRank;
+}
+
+home_map_kind_t HomeMap::getKind() const {
+    return kind;
+}
+
+const char *HomeMap::name(home_map_kind_t kind) {
+    switch (kind) {
+        case HOME_BLOCK_CYCLIC:     return "block-cyclic";
+        case HOME_PAGE_INTERLEAVED: return "page-interleaved";
+        case HOME_RANGE_TABLE:      return "range table";
+    }
+    return "unknown";
+}
@@ -0,0 +1,63 @@
+/*
+ * Home-node mappings for modelling distributed shared memory: every address
+ * has a home rank, which serves misses on (and takes writebacks of) its lines.
+ *
+ * See SimpleCache::attachNetwork(), which uses a HomeMap to generate remote
+ * traffic from cache misses and writebacks.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+typedef enum {
+    HOME_BLOCK_CYCLIC,          // blocks of an array dealt out round-robin
+    HOME_PAGE_INTERLEAVED,      // consecutive pages on consecutive ranks
+    HOME_RANGE_TABLE,           // user-given [start, end) => rank ranges
+} home_map_kind_t;
+
+class HomeMap {
+    public:
+        static HomeMap blockCyclic(size_t nRanks, size_t blockNBytes,
+                uintptr_t baseAddr = 0);
+        static HomeMap pageInterleaved(size_t nRanks, size_t pageNBytes = 4096);
+        static HomeMap rangeTable(int defaultRank);
+        void addRange(uintptr_t start, uintptr_t end, int rank);
+
+        inline int home(uintptr_t addr) const;
+        home_map_kind_t getKind() const;
+        static const char *name(home_map_kind_t kind);
+
+    private:
+        typedef struct {
+            uintptr_t start, end;
+            int rank;
+        } range_t;
+
+        HomeMap(home_map_kind_t kind, size_t nRanks, size_t blockNBytes,
+                uintptr_t baseAddr, int defaultRank);
+
+        home_map_kind_t kind;
+        size_t nRanks;
+        size_t blockNBytes;
+        size_t blockNBytesLog2;     // page-interleaved only
+        uintptr_t baseAddr;
+        int defaultRank;            // range table: for unmapped addresses
+        std::vector<range_t> ranges;    // sorted by start; non-overlapping
+
+        int rangeHome(uintptr_t addr) const;
+};
+
+
+inline int HomeMap::home(uintptr_t addr) const {
+    switch (kind) {
+        case HOME_BLOCK_CYCLIC:
+            return ((addr - baseAddr) / blockNBytes) % nRanks;
+        case HOME_PAGE_INTERLEAVED:
+            return (addr >> blockNBytesLog2) % nRanks;
+        case HOME_RANGE_TABLE:
+        default:
+            return rangeHome(addr);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * Implementation of the memoized L1 stage (see L1Filter.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <fstream>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Cache.h"
+#include "L1Filter.h"
+
+static const char MAGIC[4] = { 'C', 'S', 'L', 'F' };
+static const uint32_t VERSION = 1;
+
+
+L1Filter::L1Filter(size_t L1NLines, size_t L1NWays, size_t cacheLineNBytes) {
+    this->L1NLines = L1NLines;
+    this->L1NWays = L1NWays;
+    this->cacheLineNBytes = cacheLineNBytes;
+    this->nAccesses = 0;
+}
+
+/*
+ * 64-bit FNV-1a over the addresses and read/write flags, for keying saved
+ * streams (not for security).
+ */
+uint64_t L1Filter::hashTrace(const uintptr_t *addrs, const uint8_t *isWrites,
+        size_t n) {
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h = (h ^ uint64_t(addrs[i])) * prime;
+        h = (h ^ (isWrites[i] ? 1 : 0)) * prime;
+    }
+    return (h ^ uint64_t(n)) * prime;
+}
+
+/*
+ * Runs the trace through the L1 (an LRUSimpleCache with LRUCache's L1
+ * geometry and policy), building the run stream.
+ */
+void L1Filter::filter(const uintptr_t *addrs, const uint8_t *isWrites,
+        size_t n) {
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    LRUSimpleCache L1(L1NLines, L1NWays, 1, cacheLineNBytes, false);
+    const SimpleCache::stats_t &s = *L1.getStats();
+    uint32_t lineNBytesLog2 = log2(cacheLineNBytes);
+
+    runs.clear();
+    nAccesses = n;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t line = addrs[i] >> lineNBytesLog2;
+        bool isWrite = isWrites[i];
+
+        // a repeat is an L1 hit on the MRU line, which changes nothing
+        if (!runs.empty() and runs.back().line == line) {
+            run_t &run = runs.back();
+            if (uint64_t(run.nRepeatReads) + run.nRepeatWrites < UINT32_MAX) {
+                isWrite ? ++run.nRepeatWrites : ++run.nRepeatReads;
+                continue;
+            }
+        }
+
+        size_t nHits = s.RH + s.WH, nE = s.nE;
+        L1.access(addrs[i], isWrite);
+
+        uint32_t flags = isWrite ? RUN_WRITE : 0;
+        if (s.RH + s.WH != nHits) flags |= RUN_L1_HIT;
+        if (s.nE != nE) flags |= RUN_L1_EVICTED;
+        runs.push_back(run_t{ line, 0, 0, flags, 0 });
+    }
+}
+
+/*
+ * Where loadOrFilter() keeps the stream for a trace with the given hash.
+ */
+std::string L1Filter::cachePath(const char * const dir,
+        uint64_t traceHash) const {
+    char name[128];
+    snprintf(name, sizeof(name), "/l1-%016llx-%zux%zu-%zu.cslf",
+            (unsigned long long) traceHash, L1NLines, L1NWays,
+            cacheLineNBytes);
+    return std::string(dir) + name;
+}
+
+/*
+ * Loads a saved stream, if the file exists and was made from the same trace
+ * and L1 configuration.
+ *
+ * Return value: whether it was loaded.
+ */
+bool L1Filter::load(const char * const inputFilepath, uint64_t traceHash) {
+    std::ifstream in(inputFilepath, std::ios::in | std::ios::binary);
+    char magic[4];
+    uint32_t version;
+    uint64_t header[6];     // as in save()
+    in.read(magic, sizeof(magic));
+    in.read((char *)&version, sizeof(version));
+    in.read((char *)header, sizeof(header));
+    if (!in or !std::equal(magic, magic + 4, MAGIC) or version != VERSION) {
+        return false;
+    }
+    if (header[0] != L1NLines or header[1] != L1NWays or
+            header[2] != cacheLineNBytes or header[3] != traceHash) {
+        return false;
+    }
+
+    std::vector<run_t> loaded(header[5]);
+    in.read((char *)loaded.data(), loaded.size() * sizeof(run_t));
+    if (!in) return false;
+
+    nAccesses = header[4];
+    runs.swap(loaded);
+    return true;
+}
+
+void L1Filter::save(const char * const outputFilepath, uint64_t traceHash) {
+    uint64_t header[6] = { L1NLines, L1NWays, cacheLineNBytes, traceHash,
+            nAccesses, runs.size() };
+
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    of.write(MAGIC, sizeof(MAGIC));
+    of.write((char *)&VERSION, sizeof(VERSION));
+    of.write((char *)header, sizeof(header));
+    of.write((char *)runs.data(), runs.size() * sizeof(run_t));
+    of.close();
+}
+
+/*
+ * Loads the trace's stream from dir if an earlier run saved it there, or
+ * else filters the trace and saves the result.
+ *
+ * Return value: whether it was loaded (rather than simulated).
+ */
+bool L1Filter::loadOrFilter(const char * const dir, const uintptr_t *addrs,
+        const uint8_t *isWrites, size_t n) {
+    uint64_t traceHash = hashTrace(addrs, isWrites, n);
+    std::string path = cachePath(dir, traceHash);
+    if (load(path.c_str(), traceHash)) return true;
+
+    filter(addrs, isWrites, n);
+    save(path.c_str(), traceHash);
+    return false;
+}
+
+size_t L1Filter::getL1NLines() const {
+    return L1NLines;
+}
+
+size_t L1Filter::getL1NWays() const {
+    return L1NWays;
+}
+
+size_t L1Filter::getCacheLineNBytes() const {
+    return cacheLineNBytes;
+}
+
+uint64_t L1Filter::getNAccesses() const {
+    return nAccesses;
+}
+
+const std::vector<L1Filter::run_t> &L1Filter::getRuns() const {
+    return runs;
+}
@@ -0,0 +1,65 @@
+/*
+ * Memoized L1 stage for sweeping L2 (LLC) configurations over one trace.
+ *
+ * LRUCache's L2 sees every access, not just L1 misses, so an L1 miss stream
+ * alone can't reproduce its state. What can be dropped exactly is a repeat
+ * access to the line just accessed: it hits in both levels, and leaves both
+ * LRU orders (and the miss classifier's shadow) as they were. So the
+ * filtered stream is one run per sequence of accesses to the same line: the
+ * run's first access, with its L1 outcome, and counts of the repeats.
+ * Word-granularity traces shrink several-fold, and the L1 isn't simulated
+ * again. LRUCache::replayL1Filtered() turns a run stream into the same
+ * stats a full LRUCache::access() pass would produce.
+ *
+ * Filtered streams are saved keyed by a hash of the trace and the L1
+ * configuration (see loadOrFilter()). File format (all little-endian):
+ *   char[4]  magic ("CSLF")
+ *   uint32_t version (1)
+ *   uint64_t L1NLines, L1NWays, cacheLineNBytes, traceHash
+ *   uint64_t nAccesses, nRuns
+ *   nRuns x run_t
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class L1Filter {
+    public:
+        typedef struct {
+            uint64_t line;
+            uint32_t nRepeatReads, nRepeatWrites;   // all L1 hits
+            uint32_t flags;     // RUN_*, for the run's first access
+            uint32_t reserved;
+        } run_t;
+
+        static const uint32_t RUN_WRITE = 1;
+        static const uint32_t RUN_L1_HIT = 2;
+        static const uint32_t RUN_L1_EVICTED = 4;
+
+        L1Filter(size_t L1NLines, size_t L1NWays, size_t cacheLineNBytes);
+
+        static uint64_t hashTrace(const uintptr_t *addrs,
+                const uint8_t *isWrites, size_t n);
+        void filter(const uintptr_t *addrs, const uint8_t *isWrites,
+                size_t n);
+        std::string cachePath(const char * const dir,
+                uint64_t traceHash) const;
+        bool load(const char * const inputFilepath, uint64_t traceHash);
+        void save(const char * const outputFilepath, uint64_t traceHash);
+        bool loadOrFilter(const char * const dir, const uintptr_t *addrs,
+                const uint8_t *isWrites, size_t n);
+
+        size_t getL1NLines() const;
+        size_t getL1NWays() const;
+        size_t getCacheLineNBytes() const;
+        uint64_t getNAccesses() const;
+        const std::vector<run_t> &getRuns() const;
+
+    private:
+        size_t L1NLines, L1NWays, cacheLineNBytes;
+        uint64_t nAccesses;
+        std::vector<run_t> runs;
+};
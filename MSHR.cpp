@@ -0,0 +1,86 @@
+/*
+ * Implementation of the MSHR file (see MSHR.h).
+ */
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "MSHR.h"
+
+
+MSHRFile::MSHRFile(size_t nEntries) {
+    assert(nEntries > 0);
+    entries = std::vector<entry_t>(nEntries, entry_t{ 0, 0 });
+    clearStats();
+}
+
+/*
+ * Finds an entry for a primary miss wanted at cycle now, to be filled in
+ * with fill() once the miss's completion time is known.
+ *
+ * Return value: the cycle the miss can issue (later than now if every entry
+ * was busy, in which case it takes the one that frees up first).
+ */
+uint64_t MSHRFile::acquire(uint64_t now, size_t &entry) {
+    size_t nBusy = 0;
+    size_t earliest = 0, free = entries.size();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].readyAt > now) ++nBusy;
+        else if (free == entries.size()) free = i;
+        if (entries[i].readyAt < entries[earliest].readyAt) earliest = i;
+    }
+    occupancyAtMiss.record(nBusy);
+
+    if (free != entries.size()) {
+        entry = free;
+        return now;
+    }
+
+    ++nFullStalls;
+    stallCycles += entries[earliest].readyAt - now;
+    entry = earliest;
+    return entries[earliest].readyAt;
+}
+
+void MSHRFile::fill(size_t entry, uint64_t line, uint64_t issueAt,
+        uint64_t readyAt) {
+    assert(readyAt >= issueAt);
+    entries[entry].line = line;
+    entries[entry].readyAt = readyAt;
+    busyCycles += readyAt - issueAt;
+}
+
+/*
+ * Zeroes the counters, leaving in-flight misses alone.
+ */
+void MSHRFile::clearStats() {
+    nFullStalls = 0;
+    stallCycles = 0;
+    busyCycles = 0;
+    occupancyAtMiss.clear();
+}
+
+size_t MSHRFile::getNEntries() const {
+    return entries.size();
+}
+
+size_t MSHRFile::getNFullStalls() const {
+    return nFullStalls;
+}
+
+uint64_t MSHRFile::getStallCycles() const {
+    return stallCycles;
+}
+
+/*
+ * Time-averaged number of busy entries over elapsedCycles (Little's law).
+ */
+double MSHRFile::getMeanOccupancy(uint64_t elapsedCycles) const {
+    return elapsedCycles == 0 ? 0.0 :
+            double(busyCycles) / double(elapsedCycles);
+}
+
+const Histogram &MSHRFile::getOccupancyAtMiss() const {
+    return occupancyAtMiss;
+}
@@ -0,0 +1,64 @@
+/*
+ * Miss status holding registers (MSHRs) for a non-blocking cache level.
+ *
+ * Each entry tracks one in-flight line and the cycle its fill completes.
+ * Later misses to an in-flight line are secondary misses, which coalesce into
+ * the existing entry instead of going to the next level again. A primary
+ * miss needs a free entry; when all are busy, it stalls until the earliest
+ * fill completes.
+ *
+ * MSHR files are small (a few to a few dozen entries), so entries live in a
+ * flat array that is scanned linearly.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Histogram.h"
+
+class MSHRFile {
+    public:
+        MSHRFile(size_t nEntries);
+        inline bool inFlight(uint64_t line, uint64_t now,
+                uint64_t &readyAt) const;
+        uint64_t acquire(uint64_t now, size_t &entry);
+        void fill(size_t entry, uint64_t line, uint64_t issueAt,
+                uint64_t readyAt);
+        void clearStats();
+
+        size_t getNEntries() const;
+        size_t getNFullStalls() const;
+        uint64_t getStallCycles() const;
+        double getMeanOccupancy(uint64_t elapsedCycles) const;
+        const Histogram &getOccupancyAtMiss() const;
+
+    private:
+        typedef struct {
+            uint64_t line;
+            uint64_t readyAt;       // free once readyAt <= now
+        } entry_t;
+
+        std::vector<entry_t> entries;
+        size_t nFullStalls;
+        uint64_t stallCycles;
+        uint64_t busyCycles;        // summed over entries
+        Histogram occupancyAtMiss;  // busy entries seen by each primary miss
+};
+
+
+/*
+ * Returns whether line has a fill in flight at cycle now, and if so, when
+ * it completes.
+ */
+inline bool MSHRFile::inFlight(uint64_t line, uint64_t now,
+        uint64_t &readyAt) const {
+    for (const entry_t &e : entries) {
+        if (e.line == line and e.readyAt > now) {
+            readyAt = e.readyAt;
+            return true;
+        }
+    }
+    return false;
+}
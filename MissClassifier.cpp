@@ -0,0 +1,29 @@
+/*
+ * Implementation of the 3C miss classifier (see MissClassifier.h).
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "MissClassifier.h"
+
+
+MissClassifier::MissClassifier(size_t nLines, size_t cacheLineSizeLog2) :
+        shadow(nLines), touched(cacheLineSizeLog2) {
+}
+
+/*
+ * Every line the classifier has seen, i.e., the footprint of the stream.
+ */
+const FootprintBitmap &MissClassifier::getFootprint() const {
+    return touched;
+}
+
+const char *MissClassifier::name(miss_class_t missClass) {
+    switch (missClass) {
+        case MISS_COMPULSORY:   return "COMPULSORY";
+        case MISS_CAPACITY:     return "CAPACITY";
+        case MISS_CONFLICT:     return "CONFLICT";
+        case N_MISS_CLASSES:    break;
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,49 @@
+/*
+ * 3C (compulsory/capacity/conflict) miss classifier.
+ *
+ * Runs alongside a set-associative cache, and sees every access it does:
+ *  - a miss to a line never referenced before is compulsory,
+ *  - a miss that also misses a same-capacity fully-associative LRU shadow
+ *    is a capacity miss,
+ *  - any other miss (i.e., one the shadow would have hit) is a conflict miss.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FootprintBitmap.h"
+#include "FullyAssocLRU.h"
+
+typedef enum {
+    MISS_COMPULSORY,
+    MISS_CAPACITY,
+    MISS_CONFLICT,
+    N_MISS_CLASSES,
+} miss_class_t;
+
+class MissClassifier {
+    public:
+        MissClassifier(size_t nLines, size_t cacheLineSizeLog2);
+        inline miss_class_t access(uint64_t lineAddr, bool allocate);
+        const FootprintBitmap &getFootprint() const;
+        static const char *name(miss_class_t missClass);
+
+    private:
+        FullyAssocLRU shadow;
+        FootprintBitmap touched;    // first-touch (compulsory miss) detector
+};
+
+/*
+ * Updates the shadow state with this access, and returns the class this
+ * access *would* have if the real cache missed on it. allocate should mirror
+ * the real cache's allocation decision (e.g., for write-allocate-only caches).
+ */
+inline miss_class_t MissClassifier::access(uint64_t lineAddr, bool allocate) {
+    bool evicted;
+    uint64_t evictedLine;
+    bool shadowHit = shadow.touch(lineAddr, allocate, evicted, evictedLine);
+
+    if (touched.touch(lineAddr)) return MISS_COMPULSORY;
+    return shadowHit ? MISS_CONFLICT : MISS_CAPACITY;
+}
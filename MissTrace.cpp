@@ -0,0 +1,161 @@
+/*
+ * Implementation of the miss trace writer and reader (see MissTrace.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <fstream>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "MissTrace.h"
+
+static const char MAGIC[4] = { 'C', 'S', 'M', 'T' };
+static const uint32_t VERSION = 1;
+
+
+MissTraceWriter::MissTraceWriter(const char * const outputFilepath,
+        size_t cacheLineNBytes, size_t bufferNBytes) :
+        of(outputFilepath, std::ios::out | std::ios::binary) {
+    assert(bufferNBytes >= MAX_RECORD_NBYTES);
+    buffers[0].resize(bufferNBytes);
+    buffers[1].resize(bufferNBytes);
+    this->curBuffer = 0;
+    this->curNBytes = 0;
+    this->prevIndex = 0;
+    this->prevLine = 0;
+    this->nRecords = 0;
+    this->closed = false;
+    this->fullPending = false;
+    this->stopping = false;
+    this->fullBuffer = 0;
+    this->fullNBytes = 0;
+
+    uint64_t lineNBytes = cacheLineNBytes;
+    of.write(MAGIC, sizeof(MAGIC));
+    of.write((char *)&VERSION, sizeof(VERSION));
+    of.write((char *)&lineNBytes, sizeof(lineNBytes));
+    this->nBytes = sizeof(MAGIC) + sizeof(VERSION) + sizeof(lineNBytes);
+
+    writer = std::thread(&MissTraceWriter::writerLoop, this);
+}
+
+MissTraceWriter::~MissTraceWriter() {
+    close();
+}
+
+/*
+ * Writes out whatever's buffered, and closes the file. Further records are
+ * not allowed.
+ */
+void MissTraceWriter::close() {
+    if (closed) return;
+    if (curNBytes != 0) handOff();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+    of.close();
+    closed = true;
+}
+
+/*
+ * Passes the current buffer to the writer thread (waiting for it to finish
+ * with the other one first), and starts filling the other one.
+ */
+void MissTraceWriter::handOff() {
+    assert(!closed);
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this]() { return !fullPending; });
+    fullBuffer = curBuffer;
+    fullNBytes = curNBytes;
+    fullPending = true;
+    guard.unlock();
+    changed.notify_all();
+
+    nBytes += curNBytes;
+    curBuffer ^= 1;
+    curNBytes = 0;
+}
+
+void MissTraceWriter::writerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this]() { return fullPending or stopping; });
+        if (!fullPending) return;   // stopping, and nothing left to write
+
+        // the simulator won't touch this buffer until we clear fullPending
+        guard.unlock();
+        of.write((char *)buffers[fullBuffer].data(), fullNBytes);
+        guard.lock();
+
+        fullPending = false;
+        changed.notify_all();
+    }
+}
+
+uint64_t MissTraceWriter::getNRecords() const {
+    return nRecords;
+}
+
+uint64_t MissTraceWriter::getNBytes() const {
+    return nBytes + curNBytes;
+}
+
+
+MissTraceReader::MissTraceReader(const char * const inputFilepath) :
+        in(inputFilepath, std::ios::in | std::ios::binary) {
+    char magic[4];
+    uint32_t version;
+    in.read(magic, sizeof(magic));
+    in.read((char *)&version, sizeof(version));
+    in.read((char *)&cacheLineNBytes, sizeof(cacheLineNBytes));
+    assert(in and std::equal(magic, magic + 4, MAGIC) and version == VERSION);
+
+    this->prevIndex = 0;
+    this->prevLine = 0;
+}
+
+/*
+ * Reads the next record.
+ *
+ * Return value: false at the end of the trace.
+ */
+bool MissTraceReader::next(uint64_t &accessIndex, uint64_t &line,
+        bool &isWriteback) {
+    uint64_t indexDelta, lineField;
+    if (!getVarint(indexDelta)) return false;
+    bool ok = getVarint(lineField);
+    assert(ok);     // truncated record
+
+    uint64_t zigzag = lineField >> 1;
+    int64_t lineDelta = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+    accessIndex = prevIndex + indexDelta;
+    line = prevLine + uint64_t(lineDelta);
+    isWriteback = lineField & 1;
+
+    prevIndex = accessIndex;
+    prevLine = line;
+    return true;
+}
+
+uint64_t MissTraceReader::getCacheLineNBytes() const {
+    return cacheLineNBytes;
+}
+
+bool MissTraceReader::getVarint(uint64_t &value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF) return false;
+        value |= uint64_t(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    assert(false);  // corrupt varint
+    return false;
+}
@@ -0,0 +1,105 @@
+/*
+ * Compact on-disk trace of a cache level's outgoing traffic: its misses
+ * (line fills) and writebacks, each stamped with the index of the access
+ * that caused it. Downstream simulators can replay just this filtered
+ * stream instead of the full access trace.
+ *
+ * File format (all little-endian):
+ *   char[4]  magic ("CSMT")
+ *   uint32_t version (1)
+ *   uint64_t cacheLineNBytes
+ *   then per record, two LEB128 varints:
+ *     access index minus the previous record's (indices never decrease)
+ *     (zigzag(line minus the previous record's line) << 1) | isWriteback
+ * Both deltas start from 0. Streams with locality take 2-4 bytes a record.
+ *
+ * MissTraceWriter encodes into one buffer while a background thread writes
+ * out the other, so the simulator only blocks if the disk falls behind.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+class MissTraceWriter {
+    public:
+        MissTraceWriter(const char * const outputFilepath,
+                size_t cacheLineNBytes, size_t bufferNBytes = 1 << 20);
+        ~MissTraceWriter();
+        MissTraceWriter(const MissTraceWriter &) = delete;
+        MissTraceWriter &operator=(const MissTraceWriter &) = delete;
+
+        inline void record(uint64_t accessIndex, uint64_t line,
+                bool isWriteback);
+        void close();
+
+        uint64_t getNRecords() const;
+        uint64_t getNBytes() const;     // including the header
+
+    private:
+        // the longest a record can encode to (two 64-bit varints)
+        static const size_t MAX_RECORD_NBYTES = 2 * 10;
+
+        std::ofstream of;
+        std::vector<uint8_t> buffers[2];
+        size_t curBuffer, curNBytes;
+        uint64_t prevIndex, prevLine;
+        uint64_t nRecords, nBytes;
+        bool closed;
+
+        // hand-off to the writer thread: at most one full buffer at a time
+        std::thread writer;
+        std::mutex lock;
+        std::condition_variable changed;
+        bool fullPending, stopping;
+        size_t fullBuffer, fullNBytes;
+
+        inline void putVarint(uint64_t value);
+        void handOff();
+        void writerLoop();
+};
+
+class MissTraceReader {
+    public:
+        MissTraceReader(const char * const inputFilepath);
+
+        bool next(uint64_t &accessIndex, uint64_t &line, bool &isWriteback);
+        uint64_t getCacheLineNBytes() const;
+
+    private:
+        std::ifstream in;
+        uint64_t cacheLineNBytes;
+        uint64_t prevIndex, prevLine;
+
+        bool getVarint(uint64_t &value);
+};
+
+
+inline void MissTraceWriter::putVarint(uint64_t value) {
+    uint8_t *out = &buffers[curBuffer][curNBytes];
+    while (value >= 0x80) {
+        *out++ = uint8_t(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = uint8_t(value);
+    curNBytes = out - buffers[curBuffer].data();
+}
+
+inline void MissTraceWriter::record(uint64_t accessIndex, uint64_t line,
+        bool isWriteback) {
+    if (curNBytes + MAX_RECORD_NBYTES > buffers[curBuffer].size()) handOff();
+
+    int64_t lineDelta = int64_t(line - prevLine);
+    uint64_t zigzag = (uint64_t(lineDelta) << 1) ^ uint64_t(lineDelta >> 63);
+    putVarint(accessIndex - prevIndex);
+    putVarint((zigzag << 1) | (isWriteback ? 1 : 0));
+
+    prevIndex = accessIndex;
+    prevLine = line;
+    ++nRecords;
+}
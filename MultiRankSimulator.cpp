@@ -0,0 +1,135 @@
+/*
+ * Implementation of the in-process multi-rank driver (see
+ * MultiRankSimulator.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "MultiRankSimulator.h"
+
+
+MultiRankSimulator::MultiRankSimulator(size_t nRanks, size_t nLines,
+        size_t nWays, size_t nBanks, size_t cacheLineNBytes,
+        bool allocateOnWritesOnly, size_t histogramBytesPerWord) {
+    ranks.resize(nRanks);
+    for (size_t r = 0; r < nRanks; ++r) {
+        rank_t &rank = ranks[r];
+        rank.cache.reset(new LRUSimpleCache(nLines, nWays, nBanks,
+                cacheLineNBytes, allocateOnWritesOnly));
+        rank.network.reset(new Network(r, nRanks));
+        if (histogramBytesPerWord != 0) {
+            rank.histogram.reset(new HistogramCounter(histogramBytesPerWord));
+        }
+        rank.trace = nullptr;
+        rank.traceLength = 0;
+        rank.nextRecord = 0;
+    }
+}
+
+/*
+ * Gives rank a trace to replay (the records must outlive run()).
+ */
+void MultiRankSimulator::setTrace(int rank, const trace_record_t *records,
+        size_t n) {
+    ranks[rank].trace = records;
+    ranks[rank].traceLength = n;
+    ranks[rank].nextRecord = 0;
+}
+
+/*
+ * Replays every rank's trace, and returns once they're all done.
+ */
+void MultiRankSimulator::run(WorkStealingPool &pool, size_t chunkNRecords) {
+    assert(chunkNRecords > 0);
+    for (size_t r = 0; r < ranks.size(); ++r) {
+        if (ranks[r].nextRecord >= ranks[r].traceLength) continue;
+        pool.submit([this, &pool, r, chunkNRecords]() {
+            runChunk(pool, r, chunkNRecords);
+        });
+    }
+    pool.wait();
+}
+
+void MultiRankSimulator::runChunk(WorkStealingPool &pool, size_t r,
+        size_t chunkNRecords) {
+    rank_t &rank = ranks[r];
+    size_t end = std::min(rank.nextRecord + chunkNRecords, rank.traceLength);
+
+    LRUSimpleCache &cache = *rank.cache;
+    Network &network = *rank.network;
+    for (size_t i = rank.nextRecord; i < end; ++i) {
+        const trace_record_t &rec = rank.trace[i];
+        switch (rec.op) {
+            case TRACE_READ:
+            case TRACE_WRITE:
+                cache.access(rec.addr, rec.op == TRACE_WRITE);
+                if (rank.histogram) {
+                    rank.histogram->access(rec.addr, rec.op == TRACE_WRITE);
+                }
+                break;
+            case TRACE_SEND:
+                network.sendTo(rec.addr, rec.nBytes);
+                break;
+            default:
+                assert(false);
+        }
+    }
+    rank.nextRecord = end;
+
+    // queue our next chunk (on this worker, unless someone steals it)
+    if (end < rank.traceLength) {
+        pool.submit([this, &pool, r, chunkNRecords]() {
+            runChunk(pool, r, chunkNRecords);
+        });
+    }
+}
+
+size_t MultiRankSimulator::getNRanks() {
+    return ranks.size();
+}
+
+LRUSimpleCache &MultiRankSimulator::getCache(int rank) {
+    return *ranks[rank].cache;
+}
+
+Network &MultiRankSimulator::getNetwork(int rank) {
+    return *ranks[rank].network;
+}
+
+HistogramCounter *MultiRankSimulator::getHistogramCounter(int rank) {
+    return ranks[rank].histogram.get();
+}
+
+/*
+ * Sums every rank's cache stats, and builds the rank-to-rank traffic matrix,
+ * the same way StatsCollector::merge() does across processes.
+ */
+void MultiRankSimulator::merge(StatsCollector::merged_t &merged) {
+    size_t nRanks = ranks.size();
+    merged.worldSize = nRanks;
+    merged.nRanksPublished = nRanks;
+    memset(&merged.stats, 0, sizeof(merged.stats));
+    merged.trafficMatrix.assign(nRanks * nRanks, 0);
+
+    for (size_t src = 0; src < nRanks; ++src) {
+        const SimpleCache::stats_t &s = *ranks[src].cache->getStats();
+        merged.stats.RH += s.RH;
+        merged.stats.RM += s.RM;
+        merged.stats.WH += s.WH;
+        merged.stats.WM += s.WM;
+        merged.stats.nE += s.nE;
+
+        Network &network = *ranks[src].network;
+        for (size_t dest = 0; dest < nRanks; ++dest) {
+            merged.trafficMatrix[src * nRanks + dest] =
+                    network.getBytesTo(dest);
+        }
+    }
+
+    SimpleCache::computeRatios(merged.stats);
+    merged.stats.computedFinalStats = true;
+}
@@ -0,0 +1,65 @@
+/*
+ * Simulates many ranks in one process, instead of one simulator per MPI rank.
+ *
+ * Every rank context has its own LRUSimpleCache, Network (with our global
+ * rank set), and optionally a HistogramCounter. Each rank's trace is replayed
+ * in chunks on a WorkStealingPool: a rank has at most one chunk in flight,
+ * and queues its next chunk when done, so ranks stay in order internally
+ * while idle threads steal whole ranks from busy ones. Afterwards, the
+ * per-rank stats and traffic are merged into a StatsCollector::merged_t.
+ */
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Cache.h"
+#include "StatsCollector.h"
+#include "WorkStealingPool.h"
+
+typedef enum {
+    TRACE_READ,
+    TRACE_WRITE,
+    TRACE_SEND,     // addr holds the destination rank
+} trace_op_t;
+
+typedef struct {
+    uint64_t addr;
+    uint32_t nBytes;    // sends only
+    uint32_t op;        // trace_op_t
+} trace_record_t;
+
+class MultiRankSimulator {
+    public:
+        MultiRankSimulator(size_t nRanks, size_t nLines, size_t nWays,
+                size_t nBanks, size_t cacheLineNBytes,
+                bool allocateOnWritesOnly, size_t histogramBytesPerWord = 0);
+        MultiRankSimulator(const MultiRankSimulator &) = delete;
+        MultiRankSimulator &operator=(const MultiRankSimulator &) = delete;
+
+        void setTrace(int rank, const trace_record_t *records, size_t n);
+        void run(WorkStealingPool &pool, size_t chunkNRecords = 1 << 16);
+
+        size_t getNRanks();
+        LRUSimpleCache &getCache(int rank);
+        Network &getNetwork(int rank);
+        HistogramCounter *getHistogramCounter(int rank);
+        void merge(StatsCollector::merged_t &merged);
+
+    private:
+        typedef struct {
+            std::unique_ptr<LRUSimpleCache> cache;
+            std::unique_ptr<Network> network;
+            std::unique_ptr<HistogramCounter> histogram;   // may be null
+            const trace_record_t *trace;                   // not owned
+            size_t traceLength;
+            size_t nextRecord;
+        } rank_t;
+
+        std::vector<rank_t> ranks;
+
+        void runChunk(WorkStealingPool &pool, size_t rank,
+                size_t chunkNRecords);
+};
@@ -0,0 +1,177 @@
+/*
+ * Implementation of the on-disk result memo (see ResultStore.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ResultStore.h"
+
+static const char MAGIC[4] = { 'C', 'S', 'R', 'S' };
+static const uint32_t VERSION = 2;
+
+const uint32_t ResultStore::RESULTS_VERSION;
+
+
+ResultStore::ResultStore(const char * const dir) : nHits(0), nMisses(0) {
+    this->dir = dir;
+}
+
+/*
+ * 64-bit FNV-1a over the class name and each parameter's 8 bytes.
+ */
+uint64_t ResultStore::hashParams(const char * const cacheClass,
+        std::initializer_list<uint64_t> params) {
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *c = cacheClass; *c != '\0'; ++c) {
+        h = (h ^ uint8_t(*c)) * prime;
+    }
+    for (uint64_t p : params) {
+        for (size_t i = 0; i < 8; ++i) {
+            h = (h ^ ((p >> (8 * i)) & 0xff)) * prime;
+        }
+    }
+    return h;
+}
+
+uint64_t ResultStore::hashConfig(const sweep_config_t &config) {
+    return hashParams("LRUSimpleCache", { config.nLines, config.nWays,
+            config.nBanks, config.cacheLineNBytes,
+            config.allocateOnWritesOnly, uint64_t(config.bankHash) });
+}
+
+uint64_t ResultStore::hashLRUCacheConfig(size_t L1NLines, size_t L1NWays,
+        size_t L2NLines, size_t L2NWays, size_t L2NBanks,
+        size_t cacheLineNBytes, bank_hash_t L2BankHash) {
+    return hashParams("LRUCache", { L1NLines, L1NWays, L2NLines, L2NWays,
+            L2NBanks, cacheLineNBytes, uint64_t(L2BankHash) });
+}
+
+std::string ResultStore::path(uint64_t traceHash, uint64_t configHash) const {
+    char name[80];
+    snprintf(name, sizeof(name), "/r%u-%016llx-%016llx.csrs",
+            RESULTS_VERSION, (unsigned long long) traceHash,
+            (unsigned long long) configHash);
+    return dir + name;
+}
+
+/*
+ * On a hit, sets cache's stats to the saved ones (e.g., for a cache that
+ * hasn't simulated anything yet).
+ */
+bool ResultStore::lookup(uint64_t traceHash, uint64_t configHash,
+        SimpleCache &cache, std::string *dump) {
+    assert(!cache.hasOptionalModels());
+    SimpleCache::stats_t *s = cache.getStats();
+    return lookupBytes(traceHash, configHash, s, sizeof(*s), dump);
+}
+
+bool ResultStore::lookup(uint64_t traceHash, uint64_t configHash,
+        Cache &cache, std::string *dump) {
+    assert(!cache.hasOptionalModels());
+    Cache::stats_t *s = cache.getStats();
+    return lookupBytes(traceHash, configHash, s, sizeof(*s), dump);
+}
+
+void ResultStore::store(uint64_t traceHash, uint64_t configHash,
+        SimpleCache &cache, const std::string &dump) {
+    assert(!cache.hasOptionalModels());
+    SimpleCache::stats_t *s = cache.getStats();
+    storeBytes(traceHash, configHash, s, sizeof(*s), dump);
+}
+
+void ResultStore::store(uint64_t traceHash, uint64_t configHash,
+        Cache &cache, const std::string &dump) {
+    assert(!cache.hasOptionalModels());
+    Cache::stats_t *s = cache.getStats();
+    storeBytes(traceHash, configHash, s, sizeof(*s), dump);
+}
+
+/*
+ * Reads a saved result, if there is one for this key, of the right size.
+ * stats is left alone unless it was found.
+ *
+ * Return value: whether it was found.
+ */
+bool ResultStore::lookupBytes(uint64_t traceHash, uint64_t configHash,
+        void *stats, size_t statsNBytes, std::string *dump) {
+    std::string filepath = path(traceHash, configHash);
+    std::ifstream in(filepath, std::ios::in | std::ios::binary);
+    char magic[4];
+    uint32_t version;
+    uint64_t header[5];     // as in storeBytes()
+    in.read(magic, sizeof(magic));
+    in.read((char *)&version, sizeof(version));
+    in.read((char *)header, sizeof(header));
+    bool found = in and std::equal(magic, magic + 4, MAGIC) and
+            version == VERSION and header[0] == RESULTS_VERSION and
+            header[1] == traceHash and header[2] == configHash and
+            header[3] == statsNBytes;
+
+    std::vector<char> loaded(found ? statsNBytes : 0);
+    std::string loadedDump(found ? header[4] : 0, '\0');
+    if (found) {
+        in.read(loaded.data(), statsNBytes);
+        in.read(&loadedDump[0], loadedDump.size());
+        found = bool(in);
+    }
+
+    if (!found) {
+        nMisses.fetch_add(1);
+        return false;
+    }
+    std::copy(loaded.begin(), loaded.end(), (char *)stats);
+    if (dump != nullptr) dump->swap(loadedDump);
+    nHits.fetch_add(1);
+    return true;
+}
+
+/*
+ * Saving is best-effort: if the result can't be written, it's just not saved.
+ */
+void ResultStore::storeBytes(uint64_t traceHash, uint64_t configHash,
+        const void *stats, size_t statsNBytes, const std::string &dump) {
+    uint64_t header[5] = { RESULTS_VERSION, traceHash, configHash,
+            statsNBytes, dump.size() };
+    std::string filepath = path(traceHash, configHash);
+    // unique across threads and processes, in dir so the rename is atomic
+    std::string tmpFilepath = filepath + ".XXXXXX";
+    int fd = mkstemp(&tmpFilepath[0]);
+    if (fd < 0) return;
+    fchmod(fd, 0644);
+    FILE *f = fdopen(fd, "wb");
+    if (f == nullptr) {
+        close(fd);
+        remove(tmpFilepath.c_str());
+        return;
+    }
+
+    bool ok = fwrite(MAGIC, sizeof(MAGIC), 1, f) == 1 and
+            fwrite(&VERSION, sizeof(VERSION), 1, f) == 1 and
+            fwrite(header, sizeof(header), 1, f) == 1 and
+            fwrite(stats, 1, statsNBytes, f) == statsNBytes and
+            fwrite(dump.data(), 1, dump.size(), f) == dump.size();
+    ok = fclose(f) == 0 and ok;
+
+    if (!ok or rename(tmpFilepath.c_str(), filepath.c_str()) != 0) {
+        remove(tmpFilepath.c_str());
+    }
+}
+
+size_t ResultStore::getNHits() const {
+    return nHits.load();
+}
+
+size_t ResultStore::getNMisses() const {
+    return nMisses.load();
+}
@@ -0,0 +1,74 @@
+/*
+ * On-disk memo of simulation results, keyed by (trace hash, configuration
+ * hash), so re-running an identical (trace, configuration) pair is a file
+ * read instead of a simulation.
+ *
+ * Traces are hashed with L1Filter::hashTrace(). Configurations are hashed
+ * from their constructor parameters, each widened to 64 bits and prefixed
+ * with the cache class, so the key doesn't depend on struct padding or
+ * field order in memory. That only describes a plain cache, so only caches
+ * without optional models (miss classification, timing, NUCA, MSHRs, bank
+ * queueing, a network, directory, DRAM or miss trace; see
+ * hasOptionalModels()) can be stored or looked up. A result is the cache's
+ * stats_t, plus optionally the text of a stats dump. One file per result, written to a unique temporary name
+ * and renamed into place, so concurrent writers of the same key (threads,
+ * or processes sharing the directory) are harmless.
+ *
+ * Results are also keyed by RESULTS_VERSION, so ones saved by a simulator
+ * that laid out stats_t differently, or simulated differently, are never
+ * returned.
+ *
+ * File format (all little-endian):
+ *   char[4]  magic ("CSRS")
+ *   uint32_t version (2)
+ *   uint64_t resultsVersion, traceHash, configHash, statsNBytes, dumpNBytes
+ *   statsNBytes of stats_t, dumpNBytes of dump text
+ */
+#pragma once
+
+#include <atomic>
+#include <initializer_list>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "Cache.h"
+#include "SweepScheduler.h"
+
+class ResultStore {
+    public:
+        // bump whenever a stats_t, or what the simulation computes, changes
+        static const uint32_t RESULTS_VERSION = 2;
+
+        ResultStore(const char * const dir);
+
+        static uint64_t hashConfig(const sweep_config_t &config);
+        static uint64_t hashLRUCacheConfig(size_t L1NLines, size_t L1NWays,
+                size_t L2NLines, size_t L2NWays, size_t L2NBanks,
+                size_t cacheLineNBytes, bank_hash_t L2BankHash);
+
+        bool lookup(uint64_t traceHash, uint64_t configHash,
+                SimpleCache &cache, std::string *dump = nullptr);
+        bool lookup(uint64_t traceHash, uint64_t configHash, Cache &cache,
+                std::string *dump = nullptr);
+        void store(uint64_t traceHash, uint64_t configHash,
+                SimpleCache &cache, const std::string &dump = "");
+        void store(uint64_t traceHash, uint64_t configHash, Cache &cache,
+                const std::string &dump = "");
+        std::string path(uint64_t traceHash, uint64_t configHash) const;
+
+        size_t getNHits() const;
+        size_t getNMisses() const;
+
+    private:
+        std::string dir;
+        std::atomic<size_t> nHits, nMisses;
+
+        static uint64_t hashParams(const char * const cacheClass,
+                std::initializer_list<uint64_t> params);
+        bool lookupBytes(uint64_t traceHash, uint64_t configHash,
+                void *stats, size_t statsNBytes, std::string *dump);
+        void storeBytes(uint64_t traceHash, uint64_t configHash,
+                const void *stats, size_t statsNBytes,
+                const std::string &dump);
+};
@@ -0,0 +1,101 @@
+/*
+ * Bounded lock-free ring for exactly one producer thread and one consumer
+ * thread, e.g., to pipeline cache levels across threads.
+ *
+ * Each side owns one index (the producer the tail, the consumer the head),
+ * and keeps a private copy of the other's, only reloading it (an atomic
+ * acquire, and a cache miss on the other core's line) when the ring looks
+ * full or empty. Each side's fields get a cache line to themselves, apart
+ * from each other and from the read-only slots and mask.
+ */
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+template <typename T>
+class SPSCRing {
+    public:
+        SPSCRing(size_t capacity);
+        SPSCRing(const SPSCRing &) = delete;
+        SPSCRing &operator=(const SPSCRing &) = delete;
+
+        inline bool tryPush(const T &item);
+        inline bool tryPop(T &item);
+        inline void push(const T &item);
+        inline void pop(T &item);
+
+    private:
+        static const size_t CACHE_LINE_NBYTES = 64;
+
+        std::vector<T> slots;
+        size_t mask;
+        char pad0[CACHE_LINE_NBYTES];
+
+        // consumer's
+        alignas(CACHE_LINE_NBYTES) std::atomic<size_t> head;
+        size_t cachedTail;
+
+        // producer's
+        alignas(CACHE_LINE_NBYTES) std::atomic<size_t> tail;
+        size_t cachedHead;
+        char pad1[CACHE_LINE_NBYTES];
+};
+
+
+/*
+ * capacity is rounded up to a power of 2.
+ */
+template <typename T>
+SPSCRing<T>::SPSCRing(size_t capacity) : head(0), tail(0) {
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    slots.resize(n);
+    mask = n - 1;
+    cachedTail = 0;
+    cachedHead = 0;
+}
+
+template <typename T>
+inline bool SPSCRing<T>::tryPush(const T &item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cachedHead > mask) {
+        cachedHead = head.load(std::memory_order_acquire);
+        if (t - cachedHead > mask) return false;    // full
+    }
+    slots[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+inline bool SPSCRing<T>::tryPop(T &item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == cachedTail) {
+        cachedTail = tail.load(std::memory_order_acquire);
+        if (h == cachedTail) return false;          // empty
+    }
+    item = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+ * Blocking versions: spin briefly, then yield (the other side may share our
+ * core).
+ */
+template <typename T>
+inline void SPSCRing<T>::push(const T &item) {
+    for (int spins = 0; !tryPush(item); ++spins) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+}
+
+template <typename T>
+inline void SPSCRing<T>::pop(T &item) {
+    for (int spins = 0; !tryPop(item); ++spins) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+}
@@ -0,0 +1,264 @@
+/*
+ * Implementation of the stack distance histogram (see StackDistance.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Histogram.h"
+#include "StackDistance.h"
+#include "WorkStealingPool.h"
+
+// bound to const references (vector fill), so it needs storage
+const uint64_t StackDistance::LRUStack::NO_LINE;
+
+
+StackDistance::LRUStack::LRUStack() {
+    lineAt = std::vector<uint64_t>(MIN_N_SLOTS, NO_LINE);
+    tree = std::vector<uint32_t>(MIN_N_SLOTS + 1, 0);
+    nextSlot = 0;
+}
+
+inline void StackDistance::LRUStack::add(uint32_t slot, int32_t delta) {
+    for (size_t i = size_t(slot) + 1; i < tree.size(); i += i & -i) {
+        tree[i] += delta;
+    }
+}
+
+/*
+ * Number of occupied slots in [0, slot].
+ */
+inline uint64_t StackDistance::LRUStack::countUpTo(uint32_t slot) const {
+    uint64_t count = 0;
+    for (size_t i = size_t(slot) + 1; i > 0; i -= i & -i) count += tree[i];
+    return count;
+}
+
+/*
+ * Moves line to the top, and returns how many lines were above it (or COLD
+ * if it wasn't in the stack).
+ */
+uint64_t StackDistance::LRUStack::touch(uint64_t line) {
+    uint64_t distance;
+    if (!remove(line, distance)) distance = COLD;
+    push(line);
+    return distance;
+}
+
+/*
+ * Takes line out of the stack, if present, and says how many lines were
+ * above it.
+ */
+bool StackDistance::LRUStack::remove(uint64_t line, uint64_t &nNewer) {
+    auto it = slotOf.find(line);
+    if (it == slotOf.end()) return false;
+
+    uint32_t slot = it->second;
+    nNewer = slotOf.size() - countUpTo(slot);
+    add(slot, -1);
+    lineAt[slot] = NO_LINE;
+    slotOf.erase(it);
+    return true;
+}
+
+/*
+ * Puts line (which must not be in the stack) on top.
+ */
+void StackDistance::LRUStack::push(uint64_t line) {
+    if (nextSlot == lineAt.size()) compact();
+    lineAt[nextSlot] = line;
+    slotOf[line] = nextSlot;
+    add(nextSlot, 1);
+    ++nextSlot;
+}
+
+/*
+ * Renumbers the occupied slots from 0 (keeping their order), leaving at
+ * least as many free slots as occupied ones, and rebuilds the tree.
+ */
+void StackDistance::LRUStack::compact() {
+    size_t nLines = slotOf.size();
+    size_t nSlots = std::max(size_t(MIN_N_SLOTS), 2 * nLines + 2);
+    assert(nSlots < UINT32_MAX);
+
+    std::vector<uint64_t> newLineAt(nSlots, NO_LINE);
+    uint32_t slot = 0;
+    for (uint32_t s = 0; s < nextSlot; ++s) {
+        if (lineAt[s] == NO_LINE) continue;
+        newLineAt[slot] = lineAt[s];
+        slotOf[lineAt[s]] = slot;
+        ++slot;
+    }
+    lineAt.swap(newLineAt);
+    nextSlot = slot;
+
+    // linear-time Fenwick build: each node pushes its sum to its parent
+    tree.assign(nSlots + 1, 0);
+    for (size_t i = 1; i <= nextSlot; ++i) tree[i] = 1;
+    for (size_t i = 1; i <= nSlots; ++i) {
+        size_t parent = i + (i & -i);
+        if (parent <= nSlots) tree[parent] += tree[i];
+    }
+}
+
+/*
+ * Appends the lines from least to most recently used.
+ */
+void StackDistance::LRUStack::linesByRecency(
+        std::vector<uint64_t> &lines) const {
+    lines.reserve(lines.size() + slotOf.size());
+    for (uint32_t s = 0; s < nextSlot; ++s) {
+        if (lineAt[s] != NO_LINE) lines.push_back(lineAt[s]);
+    }
+}
+
+size_t StackDistance::LRUStack::size() const {
+    return slotOf.size();
+}
+
+
+StackDistance::StackDistance(size_t cacheLineSizeLog2) {
+    this->cacheLineSizeLog2 = cacheLineSizeLog2;
+    clear();
+}
+
+void StackDistance::clear() {
+    stack = LRUStack();
+    distances.clear();
+    nAccesses = 0;
+    nColdMisses = 0;
+}
+
+inline void StackDistance::record(std::vector<uint64_t> &hist,
+        uint64_t distance) {
+    if (distance >= hist.size()) hist.resize(distance + 1, 0);
+    ++hist[distance];
+}
+
+void StackDistance::access(uintptr_t addr) {
+    uint64_t distance = stack.touch(addr >> cacheLineSizeLog2);
+    if (distance == LRUStack::COLD) ++nColdMisses;
+    else record(distances, distance);
+    ++nAccesses;
+}
+
+void StackDistance::accessBatch(const uintptr_t *addrs, size_t n) {
+    for (size_t i = 0; i < n; ++i) access(addrs[i]);
+}
+
+/*
+ * Equivalent to accessBatch(), but splits the trace into nChunks (default:
+ * one per pool thread) that are processed concurrently, then merged in
+ * order. The first chunk runs directly on our state.
+ */
+void StackDistance::accessBatchParallel(const uintptr_t *addrs, size_t n,
+        WorkStealingPool &pool, size_t nChunks) {
+    if (nChunks == 0) nChunks = pool.getNThreads();
+    if (nChunks < 2 or n < nChunks) {
+        accessBatch(addrs, n);
+        return;
+    }
+    size_t chunkN = (n + nChunks - 1) / nChunks;
+
+    std::vector<chunk_t> chunks(nChunks);
+    pool.submit([this, addrs, chunkN]() { accessBatch(addrs, chunkN); });
+    for (size_t k = 1; k < nChunks and k * chunkN < n; ++k) {
+        size_t begin = k * chunkN, end = std::min(n, begin + chunkN);
+        pool.submit([this, addrs, begin, end, k, &chunks]() {
+            runChunk(addrs, begin, end, chunks[k]);
+        });
+    }
+    pool.wait();
+
+    for (size_t k = 1; k < nChunks and k * chunkN < n; ++k) {
+        mergeChunk(chunks[k], std::min(n, (k + 1) * chunkN) - k * chunkN);
+        chunks[k] = chunk_t();
+    }
+}
+
+/*
+ * Runs [begin, end) of the trace on an empty stack: reuses within the chunk
+ * get their final distances, and first references are left for the merge.
+ */
+void StackDistance::runChunk(const uintptr_t *addrs, size_t begin,
+        size_t end, chunk_t &chunk) const {
+    LRUStack local;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t line = addrs[i] >> cacheLineSizeLog2;
+        uint64_t distance = local.touch(line);
+        if (distance == LRUStack::COLD) chunk.firstRefs.push_back(line);
+        else record(chunk.distances, distance);
+    }
+    local.linesByRecency(chunk.byRecency);
+}
+
+/*
+ * Resolves a chunk's first references against our state (everything before
+ * the chunk), and moves its lines to the top of our stack.
+ *
+ * The j-th first reference has seen exactly j distinct lines in the chunk,
+ * and every line newer than its previous access that the chunk hasn't
+ * touched yet. Removing each referenced line from our stack as we go keeps
+ * it from being counted twice.
+ */
+void StackDistance::mergeChunk(const chunk_t &chunk, size_t nChunkAccesses) {
+    for (size_t j = 0; j < chunk.firstRefs.size(); ++j) {
+        uint64_t nNewer;
+        if (stack.remove(chunk.firstRefs[j], nNewer)) {
+            record(distances, j + nNewer);
+        }
+        else ++nColdMisses;
+    }
+    for (uint64_t line : chunk.byRecency) stack.push(line);
+
+    if (chunk.distances.size() > distances.size()) {
+        distances.resize(chunk.distances.size(), 0);
+    }
+    for (size_t d = 0; d < chunk.distances.size(); ++d) {
+        distances[d] += chunk.distances[d];
+    }
+    nAccesses += nChunkAccesses;
+}
+
+uint64_t StackDistance::getNAccesses() const {
+    return nAccesses;
+}
+
+uint64_t StackDistance::getNColdMisses() const {
+    return nColdMisses;
+}
+
+size_t StackDistance::getNDistinctLines() const {
+    return stack.size();
+}
+
+const std::vector<uint64_t> &StackDistance::getDistances() const {
+    return distances;
+}
+
+/*
+ * Misses of a fully-associative LRU cache of nLines lines (allocating on
+ * every access) over the same trace.
+ */
+uint64_t StackDistance::missesAtCapacity(size_t nLines) const {
+    uint64_t misses = nColdMisses;
+    for (size_t d = nLines; d < distances.size(); ++d) misses += distances[d];
+    return misses;
+}
+
+void StackDistance::dumpTextStats(FILE * const f) const {
+    Histogram hist;
+    for (size_t d = 0; d < distances.size(); ++d) {
+        if (distances[d] != 0) hist.record(d, distances[d]);
+    }
+
+    fprintf(f, "------------ Stack Distance Statistics ------------\n");
+    fprintf(f, "Accesses: %zu    cold misses: %zu    distinct lines: %zu\n",
+            (size_t) nAccesses, (size_t) nColdMisses, getNDistinctLines());
+    hist.dumpText(f, "Stack distance (lines) ");
+}
@@ -0,0 +1,90 @@
+/*
+ * Exact LRU stack (reuse) distance histogram of a trace.
+ *
+ * An access's stack distance is the number of distinct other lines touched
+ * since the previous access to its line, so it hits in a fully-associative
+ * LRU cache of C lines iff its distance is below C: one pass gives the miss
+ * count of every capacity at once.
+ *
+ * Each line's most recent access gets a slot, in access order, and a Fenwick
+ * tree counts the occupied slots; the distance is the number of occupied
+ * slots after the line's old one. When slots run out they're compacted, so
+ * memory is proportional to the number of distinct lines, not accesses.
+ *
+ * accessBatchParallel() splits a trace into chunks by time. Each chunk finds
+ * its reuses within the chunk concurrently, and lists its first references
+ * (whose previous access is in an earlier chunk); a serial merge then
+ * resolves those against the state left by the earlier chunks, at a cost
+ * proportional to the chunk's distinct lines rather than its length.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+class WorkStealingPool;
+
+class StackDistance {
+    public:
+        StackDistance(size_t cacheLineSizeLog2 = 6);
+        void access(uintptr_t addr);
+        void accessBatch(const uintptr_t *addrs, size_t n);
+        void accessBatchParallel(const uintptr_t *addrs, size_t n,
+                WorkStealingPool &pool, size_t nChunks = 0);
+        void clear();
+
+        uint64_t getNAccesses() const;
+        uint64_t getNColdMisses() const;
+        size_t getNDistinctLines() const;
+        const std::vector<uint64_t> &getDistances() const;
+        uint64_t missesAtCapacity(size_t nLines) const;
+        void dumpTextStats(FILE * const f) const;
+
+    private:
+        // lines ordered by recency, with O(log n) "how many are newer"
+        class LRUStack {
+            public:
+                static const uint64_t COLD = UINT64_MAX;
+
+                LRUStack();
+                uint64_t touch(uint64_t line);
+                bool remove(uint64_t line, uint64_t &nNewer);
+                void push(uint64_t line);
+                void linesByRecency(std::vector<uint64_t> &lines) const;
+                size_t size() const;
+
+            private:
+                static const uint64_t NO_LINE = UINT64_MAX;
+                static const size_t MIN_N_SLOTS = 1 << 16;
+
+                std::unordered_map<uint64_t, uint32_t> slotOf;
+                std::vector<uint64_t> lineAt;   // [slot], or NO_LINE
+                std::vector<uint32_t> tree;     // Fenwick, 1-based
+                uint32_t nextSlot;
+
+                inline void add(uint32_t slot, int32_t delta);
+                inline uint64_t countUpTo(uint32_t slot) const;
+                void compact();
+        };
+
+        typedef struct {
+            std::vector<uint64_t> distances;
+            std::vector<uint64_t> firstRefs;    // in access order
+            std::vector<uint64_t> byRecency;    // oldest last access first
+        } chunk_t;
+
+        size_t cacheLineSizeLog2;
+        LRUStack stack;
+        std::vector<uint64_t> distances;    // [distance] => nAccesses
+        uint64_t nAccesses;
+        uint64_t nColdMisses;
+
+        static inline void record(std::vector<uint64_t> &hist,
+                uint64_t distance);
+        void runChunk(const uintptr_t *addrs, size_t begin, size_t end,
+                chunk_t &chunk) const;
+        void mergeChunk(const chunk_t &chunk, size_t nChunkAccesses);
+};
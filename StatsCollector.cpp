@@ -0,0 +1,287 @@
+/*
+ * Implementation of the shared-memory stats collector (see StatsCollector.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <system_error>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "StatsCollector.h"
+
+static void throwErrno(const char * const what, const char * const path) {
+    throw std::system_error(errno, std::generic_category(),
+            std::string("StatsCollector: ") + what + " " + path);
+}
+
+
+/*
+ * Maps (creating, if needed) the node-local segment at segmentPath. Every rank
+ * on the node must pass the same worldSize, nSlots (>= ranks on the node) and
+ * runID (neither 0 nor UINT64_MAX). Whichever rank gets there first
+ * initializes the segment, wiping anything an earlier run left in it; the
+ * rest wait for it, without taking any locks.
+ */
+StatsCollector::StatsCollector(const char * const segmentPath,
+        size_t worldSize, size_t nSlots, uint64_t runID) {
+    assert(runID != 0 and runID != STATE_BUSY);
+    this->worldSize = worldSize;
+    this->segmentNBytes = sizeof(segment_header_t) +
+            nSlots * slotNBytes(worldSize);
+    this->ourSlot = nullptr;
+
+    int fd = open(segmentPath, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throwErrno("can't open", segmentPath);
+    // every rank of a run sets the same size, and growing zero-fills
+    if (ftruncate(fd, segmentNBytes) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        throwErrno("can't size", segmentPath);
+    }
+
+    void *p = mmap(nullptr, segmentNBytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    int err = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        errno = err;
+        throwErrno("can't map", segmentPath);
+    }
+    segment = (uint8_t *) p;
+
+    segment_header_t *h = (segment_header_t *) segment;
+    while (true) {
+        uint64_t state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+        if (state == runID) break;
+        if (state == STATE_BUSY) {
+            sched_yield();
+            continue;
+        }
+
+        // fresh, or left over from another run: (re)initialize it
+        if (__atomic_compare_exchange_n(&h->state, &state, STATE_BUSY, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            memset(segment + sizeof(segment_header_t), 0,
+                    segmentNBytes - sizeof(segment_header_t));
+            h->magic = SEGMENT_MAGIC;
+            h->worldSize = worldSize;
+            h->nSlots = nSlots;
+            h->nClaimed = 0;
+            __atomic_store_n(&h->state, runID, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    assert(h->magic == SEGMENT_MAGIC);
+    assert(h->worldSize == worldSize and h->nSlots == nSlots);
+}
+
+StatsCollector::~StatsCollector() {
+    munmap(segment, segmentNBytes);
+}
+
+size_t StatsCollector::slotNBytes(size_t worldSize) {
+    return sizeof(slot_t) + worldSize * sizeof(uint64_t);
+}
+
+StatsCollector::slot_t *StatsCollector::getSlot(uint8_t *segment,
+        size_t worldSize, size_t i) {
+    return (slot_t *) (segment + sizeof(segment_header_t) +
+            i * slotNBytes(worldSize));
+}
+
+uint64_t *StatsCollector::getDestBytes(slot_t *slot) {
+    return (uint64_t *) (slot + 1);
+}
+
+/*
+ * Publishes (or re-publishes) our rank's raw cache counters and bytes sent
+ * per destination. Readers never see a half-written slot: the slot's sequence
+ * number is odd while we write it.
+ */
+void StatsCollector::publish(int rank, const SimpleCache::stats_t &stats,
+        Network &network) {
+    if (ourSlot == nullptr) {
+        segment_header_t *h = (segment_header_t *) segment;
+        uint64_t i = __atomic_fetch_add(&h->nClaimed, 1, __ATOMIC_ACQ_REL);
+        assert(i < h->nSlots);
+        ourSlot = getSlot(segment, worldSize, i);
+    }
+
+    uint64_t seq = __atomic_load_n(&ourSlot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&ourSlot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    ourSlot->rank = rank;
+    ourSlot->RH = stats.RH;
+    ourSlot->RM = stats.RM;
+    ourSlot->WH = stats.WH;
+    ourSlot->WM = stats.WM;
+    ourSlot->nE = stats.nE;
+    uint64_t *destBytes = getDestBytes(ourSlot);
+    for (size_t dest = 0; dest < worldSize; ++dest) {
+        destBytes[dest] = network.getBytesTo(dest);
+    }
+
+    __atomic_store_n(&ourSlot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Sums every published slot of every segment file into merged. The files
+ * can be live segments, or copies gathered from each node. Files that aren't
+ * (complete, initialized) segments of the same world size throw a
+ * std::system_error (EINVAL).
+ */
+void StatsCollector::merge(const std::vector<std::string> &segmentPaths,
+        merged_t &merged) {
+    merged.worldSize = 0;
+    merged.nRanksPublished = 0;
+    memset(&merged.stats, 0, sizeof(merged.stats));
+    merged.trafficMatrix.clear();
+
+    for (auto &path : segmentPaths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throwErrno("can't open", path.c_str());
+        struct stat st;
+        void *p = MAP_FAILED;
+        if (fstat(fd, &st) == 0) {
+            if (size_t(st.st_size) < sizeof(segment_header_t)) errno = EINVAL;
+            else p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        int err = errno;
+        close(fd);
+        if (p == MAP_FAILED) {
+            errno = err;
+            throwErrno("can't map", path.c_str());
+        }
+
+        // the contents aren't ours to trust: check everything we index by
+        // before reading any slot
+        auto invalid = [&](const char * const what) {
+            munmap(p, st.st_size);
+            errno = EINVAL;
+            throwErrno(what, path.c_str());
+        };
+        uint8_t *segment = (uint8_t *) p;
+        segment_header_t *h = (segment_header_t *) segment;
+        size_t slotsNBytes = st.st_size - sizeof(segment_header_t);
+        uint64_t state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+        if (h->magic != SEGMENT_MAGIC) invalid("not a segment:");
+        if (state == 0 or state == STATE_BUSY) invalid("uninitialized:");
+        if (h->worldSize == 0 or h->nSlots == 0 or
+                h->worldSize > slotsNBytes / sizeof(uint64_t) or
+                h->nSlots > slotsNBytes / slotNBytes(h->worldSize)) {
+            invalid("truncated:");
+        }
+
+        size_t worldSize = h->worldSize;
+        if (merged.worldSize == 0) {
+            merged.worldSize = worldSize;
+            merged.trafficMatrix.resize(worldSize * worldSize, 0);
+        }
+        if (worldSize != merged.worldSize) invalid("world size differs:");
+
+        size_t nClaimed = std::min(__atomic_load_n(&h->nClaimed,
+                __ATOMIC_ACQUIRE), h->nSlots);
+        std::vector<uint8_t> copy(slotNBytes(worldSize));
+        slot_t *snapshot = (slot_t *) copy.data();
+
+        for (size_t i = 0; i < nClaimed; ++i) {
+            slot_t *slot = getSlot(segment, worldSize, i);
+
+            // sequence-lock read: retry until we copy a stable, even version
+            uint64_t seqBefore, seqAfter;
+            do {
+                seqBefore = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+                if (seqBefore & 1) {
+                    sched_yield();
+                    continue;
+                }
+                memcpy(copy.data(), slot, copy.size());
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                seqAfter = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+            } while ((seqBefore & 1) or seqBefore != seqAfter);
+
+            if (seqBefore == 0) continue;   // claimed, but never published
+
+            size_t src = snapshot->rank;
+            if (src >= worldSize) invalid("rank out of range:");
+            merged.nRanksPublished++;
+            merged.stats.RH += snapshot->RH;
+            merged.stats.RM += snapshot->RM;
+            merged.stats.WH += snapshot->WH;
+            merged.stats.WM += snapshot->WM;
+            merged.stats.nE += snapshot->nE;
+
+            uint64_t *destBytes = getDestBytes(snapshot);
+            for (size_t dest = 0; dest < worldSize; ++dest) {
+                merged.trafficMatrix[src * worldSize + dest] += destBytes[dest];
+            }
+        }
+
+        munmap(p, st.st_size);
+    }
+
+    SimpleCache::computeRatios(merged.stats);
+    merged.stats.computedFinalStats = true;
+}
+
+/*
+ * Deletes a segment file (e.g., once it's been merged); it's not an error if
+ * there isn't one. Mappings that are still open stay valid.
+ */
+void StatsCollector::removeSegment(const char * const segmentPath) {
+    if (unlink(segmentPath) != 0 and errno != ENOENT) {
+        throwErrno("can't remove", segmentPath);
+    }
+}
+
+void StatsCollector::dumpTextStats(FILE * const f, const merged_t &merged) {
+    const SimpleCache::stats_t &s = merged.stats;
+
+    fprintf(f, "------------ Merged Statistics ------------\n");
+    fprintf(f, "RANKS\t%zu of %zu\n", merged.nRanksPublished,
+            merged.worldSize);
+    fprintf(f, "READ_HITS\t%zu (%.2f%%)\n", s.RH, s.RHP*100);
+    fprintf(f, "WRITE_HITS\t%zu (%.2f%%)\n", s.WH, s.WHP*100);
+    fprintf(f, "READ_MISSES\t%zu (%.2f%%)\n", s.RM, s.RMP*100);
+    fprintf(f, "WRITE_MISSES\t%zu (%.2f%%)\n", s.WM, s.WMP*100);
+    fprintf(f, "EVICTIONS\t%zu (%.2f%%)\n", s.nE, s.EP*100);
+
+    uint64_t totalBytes = 0;
+    for (uint64_t b : merged.trafficMatrix) totalBytes += b;
+    fprintf(f, "TOTAL_BYTES_SENT\t%zu\n", (size_t) totalBytes);
+}
+
+/*
+ * Dumps an N x N traffic matrix (little-endian):
+ *   char[4]  magic ("CSTM")
+ *   uint32_t version (1)
+ *   uint64_t worldSize
+ *   worldSize x worldSize x uint64_t bytes ([src][dest])
+ */
+void StatsCollector::dumpTrafficMatrix(const char * const outputFilepath,
+        const std::vector<uint64_t> &trafficMatrix, size_t worldSize) {
+    assert(trafficMatrix.size() == worldSize * worldSize);
+    const char magic[4] = { 'C', 'S', 'T', 'M' };
+    uint32_t version = 1;
+    uint64_t n = worldSize;
+
+    std::ofstream of(outputFilepath, std::ios::out | std::ios::binary);
+    of.write(magic, sizeof(magic));
+    of.write((char *)&version, sizeof(version));
+    of.write((char *)&n, sizeof(n));
+    of.write((char *)trafficMatrix.data(),
+            trafficMatrix.size() * sizeof(uint64_t));
+    of.close();
+}
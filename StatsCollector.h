@@ -0,0 +1,88 @@
+/*
+ * Cross-rank aggregation of Network and SimpleCache stats, without text
+ * parsing.
+ *
+ * All ranks on a node map the same segment file (put it on /dev/shm to keep
+ * it in shared memory), claim a slot with an atomic increment, and publish
+ * their raw counters into it under a per-slot sequence lock; no rank ever
+ * blocks another. Afterwards, merge() reads any number of node segment files
+ * and produces the full traffic matrix and the summed cache stats.
+ *
+ * Segment files outlive the run (that's what lets merge() read them later),
+ * so every rank of a run passes the same runID (e.g., the batch job ID): a
+ * segment left by a different run is wiped and reinitialized by whichever
+ * rank gets to it first, rather than mixed into this run's results. Runs
+ * must not share a segment concurrently. removeSegment() deletes one once
+ * it's been merged.
+ *
+ * OS failures (opening, sizing, mapping, or removing a segment) throw
+ * std::system_error.
+ *
+ * Segment layout (all fields 8-byte, native-endian):
+ *   header:  magic/version, state, worldSize, nSlots, nClaimed
+ *   slot[i]: seq, rank, RH, RM, WH, WM, nE, destBytes[worldSize]
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Cache.h"
+
+class StatsCollector {
+    public:
+        typedef struct {
+            size_t worldSize;
+            size_t nRanksPublished;
+            SimpleCache::stats_t stats;             // summed over ranks
+            std::vector<uint64_t> trafficMatrix;    // [src * worldSize + dest]
+        } merged_t;
+
+        StatsCollector(const char * const segmentPath, size_t worldSize,
+                size_t nSlots, uint64_t runID);
+        ~StatsCollector();
+        StatsCollector(const StatsCollector &) = delete;
+        StatsCollector &operator=(const StatsCollector &) = delete;
+
+        void publish(int rank, const SimpleCache::stats_t &stats,
+                Network &network);
+
+        static void merge(const std::vector<std::string> &segmentPaths,
+                merged_t &merged);
+        static void removeSegment(const char * const segmentPath);
+        static void dumpTextStats(FILE * const f, const merged_t &merged);
+        static void dumpTrafficMatrix(const char * const outputFilepath,
+                const std::vector<uint64_t> &trafficMatrix, size_t worldSize);
+
+    private:
+        typedef struct {
+            uint64_t magic;         // SEGMENT_MAGIC
+            uint64_t state;         // 0: fresh, STATE_BUSY: initializing,
+                                    // else the runID it's ready for
+            uint64_t worldSize;
+            uint64_t nSlots;
+            uint64_t nClaimed;      // slots handed out so far
+        } segment_header_t;
+
+        typedef struct {
+            uint64_t seq;           // odd while being written; 0 = never
+            int64_t rank;
+            uint64_t RH, RM, WH, WM, nE;
+            // followed by uint64_t destBytes[worldSize]
+        } slot_t;
+
+        static const uint64_t SEGMENT_MAGIC = 0x3143535343534543ULL;
+        static const uint64_t STATE_BUSY = UINT64_MAX;
+
+        uint8_t *segment;
+        size_t segmentNBytes;
+        size_t worldSize;
+        slot_t *ourSlot;            // claimed on first publish()
+
+        static size_t slotNBytes(size_t worldSize);
+        static slot_t *getSlot(uint8_t *segment, size_t worldSize, size_t i);
+        static uint64_t *getDestBytes(slot_t *slot);
+};
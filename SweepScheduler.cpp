@@ -0,0 +1,172 @@
+/*
+ * Implementation of the trace x configuration sweep scheduler (see
+ * SweepScheduler.h).
+ */
+#include <algorithm>
+#include <assert.h>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "L1Filter.h"
+#include "ResultStore.h"
+#include "SweepScheduler.h"
+
+
+SweepScheduler::SweepScheduler(size_t maxResidentTraces) {
+    assert(maxResidentTraces > 0);
+    this->maxResidentTraces = maxResidentTraces;
+    this->nextTrace = 0;
+    this->nResident = 0;
+    this->peakResident = 0;
+    this->store = nullptr;
+}
+
+size_t SweepScheduler::addTrace(const char * const name,
+        trace_loader_t loader) {
+    traces.emplace_back(new trace_t());
+    traces.back()->name = name;
+    traces.back()->loader = loader;
+    traces.back()->nPending = 0;
+    traces.back()->hash = 0;
+    return traces.size() - 1;
+}
+
+size_t SweepScheduler::addConfig(const char * const name,
+        const sweep_config_t &config) {
+    configs.push_back(config_entry_t{ name, config });
+    return configs.size() - 1;
+}
+
+/*
+ * Looks results up in (and saves them to) store, if not null.
+ */
+void SweepScheduler::setResultStore(ResultStore *store) {
+    this->store = store;
+}
+
+/*
+ * Simulates every (trace, configuration) pair, and returns once all are done.
+ */
+void SweepScheduler::run(WorkStealingPool &pool) {
+    SimpleCache::stats_t zero;
+    memset(&zero, 0, sizeof(zero));
+    results.assign(traces.size() * configs.size(), zero);
+
+    nextTrace = 0;
+    nResident = 0;
+    peakResident = 0;
+    if (configs.empty()) return;
+
+    size_t nFirst = std::min(maxResidentTraces, traces.size());
+    for (size_t i = 0; i < nFirst; ++i) loadNextTrace(pool);
+    pool.wait();
+    assert(nextTrace == traces.size() and nResident == 0);
+}
+
+/*
+ * Queues the load of the next trace not started yet, if any.
+ */
+void SweepScheduler::loadNextTrace(WorkStealingPool &pool) {
+    size_t t;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (nextTrace == traces.size()) return;
+        t = nextTrace++;
+        ++nResident;
+        peakResident = std::max(peakResident, nResident);
+    }
+    pool.submit([this, &pool, t]() { loadTrace(pool, t); });
+}
+
+void SweepScheduler::loadTrace(WorkStealingPool &pool, size_t t) {
+    trace_t &trace = *traces[t];
+    trace.loader(trace.addrs, trace.isWrites);
+    assert(trace.addrs.size() == trace.isWrites.size());
+
+    if (store) {
+        trace.hash = L1Filter::hashTrace(trace.addrs.data(),
+                trace.isWrites.data(), trace.addrs.size());
+    }
+    trace.nPending = configs.size();
+    for (size_t c = 0; c < configs.size(); ++c) {
+        pool.submit([this, &pool, t, c]() { simulate(pool, t, c); });
+    }
+}
+
+void SweepScheduler::simulate(WorkStealingPool &pool, size_t t, size_t c) {
+    const trace_t &trace = *traces[t];
+    const sweep_config_t &config = configs[c].config;
+
+    LRUSimpleCache cache(config.nLines, config.nWays, config.nBanks,
+            config.cacheLineNBytes, config.allocateOnWritesOnly,
+            config.bankHash);
+    uint64_t configHash = store ? ResultStore::hashConfig(config) : 0;
+    if (!store or !store->lookup(trace.hash, configHash, cache)) {
+        cache.accessBatch(trace.addrs.data(), trace.isWrites.data(),
+                trace.addrs.size());
+        cache.computeStats();
+        if (store) store->store(trace.hash, configHash, cache);
+    }
+    results[t * configs.size() + c] = *cache.getStats();
+
+    if (traces[t]->nPending.fetch_sub(1) == 1) releaseTrace(pool, t);
+}
+
+/*
+ * Frees a trace every configuration is done with, making room for the next.
+ */
+void SweepScheduler::releaseTrace(WorkStealingPool &pool, size_t t) {
+    trace_t &trace = *traces[t];
+    std::vector<uintptr_t>().swap(trace.addrs);
+    std::vector<uint8_t>().swap(trace.isWrites);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        --nResident;
+    }
+    loadNextTrace(pool);
+}
+
+const SimpleCache::stats_t &SweepScheduler::getResult(size_t trace,
+        size_t config) const {
+    return results[trace * configs.size() + config];
+}
+
+size_t SweepScheduler::getPeakResidentTraces() const {
+    return peakResident;
+}
+
+/*
+ * One tab-separated line per (trace, configuration), after a header line.
+ */
+void SweepScheduler::dumpTextResults(FILE * const f) const {
+    fprintf(f, "TRACE\tCONFIG\tLINES\tWAYS\tBANKS\tLINE_BYTES\tWRITE_ONLY\t"
+            "BANK_HASH\tREAD_HITS\tWRITE_HITS\tREAD_MISSES\tWRITE_MISSES\t"
+            "EVICTIONS\tMISS_RATE\n");
+    for (size_t t = 0; t < traces.size(); ++t) {
+        for (size_t c = 0; c < configs.size(); ++c) {
+            const sweep_config_t &config = configs[c].config;
+            const SimpleCache::stats_t &s = getResult(t, c);
+            size_t nAccesses = s.nR + s.nW;
+            fprintf(f, "%s\t%s\t%zu\t%zu\t%zu\t%zu\t%d\t%s\t"
+                    "%zu\t%zu\t%zu\t%zu\t%zu\t%.6f\n",
+                    traces[t]->name.c_str(), configs[c].name.c_str(),
+                    config.nLines, config.nWays, config.nBanks,
+                    config.cacheLineNBytes, int(config.allocateOnWritesOnly),
+                    BankHasher::name(config.bankHash),
+                    s.RH, s.WH, s.RM, s.WM, s.nE,
+                    nAccesses == 0 ? 0.0 : double(s.nM) / nAccesses);
+        }
+    }
+}
+
+void SweepScheduler::dumpTextResults(const char * const outputFilepath) const {
+    FILE *f = fopen(outputFilepath, "w");
+    assert(f != nullptr);
+    dumpTextResults(f);
+    fclose(f);
+}
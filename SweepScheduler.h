@@ -0,0 +1,92 @@
+/*
+ * Runs the cross product of traces and LRUSimpleCache configurations in one
+ * process.
+ *
+ * Each trace is decoded once, by its loader, and shared read-only by every
+ * configuration simulating it; once the last one is done, the trace is freed
+ * and the next one is loaded. At most maxResidentTraces are in memory at a
+ * time, which bounds memory, and keeps enough (trace, configuration) jobs
+ * queued for the WorkStealingPool to balance. Results are kept per job, and
+ * written to a single file in (trace, configuration) order, however the jobs
+ * were scheduled.
+ *
+ * With a ResultStore, each decoded trace is hashed, and pairs the store
+ * already has are filled in from it instead of simulated; new results are
+ * saved to it.
+ */
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Cache.h"
+#include "WorkStealingPool.h"
+
+typedef struct {
+    size_t nLines, nWays, nBanks;
+    size_t cacheLineNBytes;
+    bool allocateOnWritesOnly;
+    bank_hash_t bankHash;
+} sweep_config_t;
+
+class ResultStore;
+
+class SweepScheduler {
+    public:
+        // fills in the decoded trace (both vectors the same length)
+        typedef std::function<void(std::vector<uintptr_t> &addrs,
+                std::vector<uint8_t> &isWrites)> trace_loader_t;
+
+        SweepScheduler(size_t maxResidentTraces = 2);
+        SweepScheduler(const SweepScheduler &) = delete;
+        SweepScheduler &operator=(const SweepScheduler &) = delete;
+
+        size_t addTrace(const char * const name, trace_loader_t loader);
+        size_t addConfig(const char * const name,
+                const sweep_config_t &config);
+        void setResultStore(ResultStore *store);
+        void run(WorkStealingPool &pool);
+
+        const SimpleCache::stats_t &getResult(size_t trace,
+                size_t config) const;
+        size_t getPeakResidentTraces() const;
+        void dumpTextResults(FILE * const f) const;
+        void dumpTextResults(const char * const outputFilepath) const;
+
+    private:
+        typedef struct {
+            std::string name;
+            trace_loader_t loader;
+            std::vector<uintptr_t> addrs;       // empty unless resident
+            std::vector<uint8_t> isWrites;
+            std::atomic<size_t> nPending;       // configurations left
+            uint64_t hash;                      // with a ResultStore
+        } trace_t;
+
+        typedef struct {
+            std::string name;
+            sweep_config_t config;
+        } config_entry_t;
+
+        size_t maxResidentTraces;
+        std::vector<std::unique_ptr<trace_t>> traces;
+        std::vector<config_entry_t> configs;
+        std::vector<SimpleCache::stats_t> results;  // [trace * nConfigs + c]
+        ResultStore *store;                         // may be null
+
+        std::mutex lock;            // guards the fields below
+        size_t nextTrace;
+        size_t nResident, peakResident;
+
+        void loadNextTrace(WorkStealingPool &pool);
+        void loadTrace(WorkStealingPool &pool, size_t t);
+        void simulate(WorkStealingPool &pool, size_t t, size_t c);
+        void releaseTrace(WorkStealingPool &pool, size_t t);
+};
@@ -0,0 +1,271 @@
+/*
+ * Implementation of the interconnect topologies (see Topology.h).
+ */
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Topology.h"
+
+
+Topology::Topology(topology_kind_t kind, size_t dim0, size_t dim1,
+        size_t dim2) {
+    this->kind = kind;
+    this->dims[0] = dim0;
+    this->dims[1] = dim1;
+    this->dims[2] = dim2;
+    this->nSwitchesPerLevel = 0;
+
+    switch (kind) {
+        case TOPO_MESH_2D:
+        case TOPO_TORUS_2D:
+            nRanks = dim0 * dim1;
+            nLinks = nRanks * 4;    // +x, -x, +y, -y out of every router
+            break;
+        case TOPO_FAT_TREE:
+            nRanks = 1;
+            for (size_t l = 0; l < dim1; ++l) nRanks *= dim0;
+            nSwitchesPerLevel = nRanks / dim0;
+            // an up and a down link per (lower switch, upper port)
+            nLinks = 2 * (dim1 - 1) * nSwitchesPerLevel * dim0;
+            break;
+        case TOPO_DRAGONFLY:
+            nRanks = dim0 * dim1 * dim2;
+            // all-to-all routers within a group, all-to-all groups
+            nLinks = dim0 * dim1 * dim1 + dim0 * dim0;
+            break;
+    }
+    assert(nRanks > 0);
+}
+
+/*
+ * Rank r sits on router (r % width, r / width).
+ */
+Topology Topology::mesh2D(size_t width, size_t height) {
+    return Topology(TOPO_MESH_2D, width, height, 1);
+}
+
+Topology Topology::torus2D(size_t width, size_t height) {
+    return Topology(TOPO_TORUS_2D, width, height, 1);
+}
+
+/*
+ * k-ary n-tree: radix^nLevels ranks, radix ranks per leaf switch, and
+ * nLevels levels of radix^(nLevels-1) switches each.
+ */
+Topology Topology::fatTree(size_t radix, size_t nLevels) {
+    assert(radix >= 2 and nLevels >= 1);
+    return Topology(TOPO_FAT_TREE, radix, nLevels, 1);
+}
+
+/*
+ * Rank r sits on router r / ranksPerRouter, and router q is in group
+ * q / routersPerGroup. Every pair of groups has one global link.
+ */
+Topology Topology::dragonfly(size_t nGroups, size_t routersPerGroup,
+        size_t ranksPerRouter) {
+    return Topology(TOPO_DRAGONFLY, nGroups, routersPerGroup, ranksPerRouter);
+}
+
+topology_kind_t Topology::getKind() const {
+    return kind;
+}
+
+size_t Topology::getNRanks() const {
+    return nRanks;
+}
+
+size_t Topology::getNLinks() const {
+    return nLinks;
+}
+
+/*
+ * Replaces the contents of links with the IDs of the links a message from
+ * srcRank to destRank traverses, in order.
+ */
+void Topology::route(int srcRank, int destRank,
+        std::vector<uint32_t> &links) const {
+    assert(srcRank >= 0 and size_t(srcRank) < nRanks);
+    assert(destRank >= 0 and size_t(destRank) < nRanks);
+    links.clear();
+
+    switch (kind) {
+        case TOPO_MESH_2D:
+        case TOPO_TORUS_2D:
+            routeMesh(srcRank, destRank, links);
+            break;
+        case TOPO_FAT_TREE:
+            routeFatTree(srcRank, destRank, links);
+            break;
+        case TOPO_DRAGONFLY:
+            routeDragonfly(srcRank, destRank, links);
+            break;
+    }
+}
+
+/*
+ * Dimension-order (X, then Y) routing. On a torus, each dimension goes the
+ * short way around (ties go in the + direction).
+ */
+void Topology::routeMesh(size_t src, size_t dest,
+        std::vector<uint32_t> &links) const {
+    size_t width = dims[0], height = dims[1];
+    size_t x = src % width, y = src / width;
+    size_t destX = dest % width, destY = dest / width;
+    bool isTorus = kind == TOPO_TORUS_2D;
+
+    while (x != destX) {
+        bool plus = isTorus ? (destX + width - x) % width <= width / 2 :
+                destX > x;
+        links.push_back((y * width + x) * 4 + (plus ? 0 : 1));
+        x = plus ? (x + 1) % width : (x + width - 1) % width;
+    }
+    while (y != destY) {
+        bool plus = isTorus ? (destY + height - y) % height <= height / 2 :
+                destY > y;
+        links.push_back((y * width + x) * 4 + (plus ? 2 : 3));
+        y = plus ? (y + 1) % height : (y + height - 1) % height;
+    }
+}
+
+/*
+ * D-mod-k routing: climb to the lowest common ancestor level, picking the up
+ * port at each level from the destination's digits, then descend.
+ *
+ * A leaf switch's label is its ranks' digits without the lowest one, and an
+ * up link out of level l rewrites label digit l. Link (level l, lower switch
+ * w, port p) has up ID (l * nSwitchesPerLevel + w) * radix + p, and its down
+ * twin sits half of nLinks later.
+ */
+void Topology::routeFatTree(size_t src, size_t dest,
+        std::vector<uint32_t> &links) const {
+    size_t radix = dims[0], nLevels = dims[1];
+    size_t nUpLinks = nLinks / 2;
+
+    // highest differing digit of the rank numbers
+    size_t top = 0;
+    size_t s = src, d = dest;
+    for (size_t i = 0; i < nLevels; ++i) {
+        if (s % radix != d % radix) top = i;
+        s /= radix;
+        d /= radix;
+    }
+    if (src == dest or top == 0) return;    // same leaf switch
+
+    size_t w = src / radix;
+    size_t destW = dest / radix;
+    size_t digitWeight = 1;
+    for (size_t l = 0; l < top; ++l) {
+        size_t p = (destW / digitWeight) % radix;
+        links.push_back((l * nSwitchesPerLevel + w) * radix + p);
+        w = w - ((w / digitWeight) % radix) * digitWeight + p * digitWeight;
+        digitWeight *= radix;
+    }
+    assert(w == destW);
+
+    for (size_t l = top; l-- > 0; ) {
+        digitWeight /= radix;
+        size_t p = (w / digitWeight) % radix;
+        links.push_back(nUpLinks + (l * nSwitchesPerLevel + w) * radix + p);
+    }
+}
+
+/*
+ * Minimal routing: (local hop to the gateway router) + global hop + (local
+ * hop to the destination router). Group G's link to group H hangs off router
+ * ((H - G - 1) mod nGroups) mod routersPerGroup.
+ */
+void Topology::routeDragonfly(size_t src, size_t dest,
+        std::vector<uint32_t> &links) const {
+    size_t nGroups = dims[0], routersPerGroup = dims[1];
+    size_t ranksPerRouter = dims[2];
+    size_t nLocalLinks = nGroups * routersPerGroup * routersPerGroup;
+
+    size_t srcRouter = src / ranksPerRouter;
+    size_t destRouter = dest / ranksPerRouter;
+    size_t srcGroup = srcRouter / routersPerGroup;
+    size_t destGroup = destRouter / routersPerGroup;
+    size_t srcR = srcRouter % routersPerGroup;
+    size_t destR = destRouter % routersPerGroup;
+
+    if (srcGroup == destGroup) {
+        if (srcR != destR) {
+            links.push_back((srcGroup * routersPerGroup + srcR) *
+                    routersPerGroup + destR);
+        }
+        return;
+    }
+
+    size_t outR = ((destGroup + nGroups - srcGroup - 1) % nGroups) %
+            routersPerGroup;
+    size_t inR = ((srcGroup + nGroups - destGroup - 1) % nGroups) %
+            routersPerGroup;
+
+    if (srcR != outR) {
+        links.push_back((srcGroup * routersPerGroup + srcR) *
+                routersPerGroup + outR);
+    }
+    links.push_back(nLocalLinks + srcGroup * nGroups + destGroup);
+    if (inR != destR) {
+        links.push_back((destGroup * routersPerGroup + inR) *
+                routersPerGroup + destR);
+    }
+}
+
+std::string Topology::linkName(size_t link) const {
+    char buf[128];
+    assert(link < nLinks);
+
+    switch (kind) {
+        case TOPO_MESH_2D:
+        case TOPO_TORUS_2D: {
+            const char *dirs[] = { "+x", "-x", "+y", "-y" };
+            size_t router = link / 4;
+            snprintf(buf, sizeof(buf), "(%zu,%zu)%s", router % dims[0],
+                    router / dims[0], dirs[link % 4]);
+            break;
+        }
+        case TOPO_FAT_TREE: {
+            size_t nUpLinks = nLinks / 2;
+            bool isUp = link < nUpLinks;
+            size_t idx = isUp ? link : link - nUpLinks;
+            size_t port = idx % dims[0];
+            size_t sw = (idx / dims[0]) % nSwitchesPerLevel;
+            size_t level = idx / dims[0] / nSwitchesPerLevel;
+            snprintf(buf, sizeof(buf), "L%zu sw%zu %s port %zu", level, sw,
+                    isUp ? "up" : "down from", port);
+            break;
+        }
+        case TOPO_DRAGONFLY: {
+            size_t routersPerGroup = dims[1];
+            size_t nLocalLinks = dims[0] * routersPerGroup * routersPerGroup;
+            if (link < nLocalLinks) {
+                snprintf(buf, sizeof(buf), "g%zu r%zu->r%zu",
+                        link / (routersPerGroup * routersPerGroup),
+                        (link / routersPerGroup) % routersPerGroup,
+                        link % routersPerGroup);
+            }
+            else {
+                snprintf(buf, sizeof(buf), "g%zu->g%zu",
+                        (link - nLocalLinks) / dims[0],
+                        (link - nLocalLinks) % dims[0]);
+            }
+            break;
+        }
+    }
+
+    return std::string(buf);
+}
+
+const char *Topology::name(topology_kind_t kind) {
+    switch (kind) {
+        case TOPO_MESH_2D:      return "2D mesh";
+        case TOPO_TORUS_2D:     return "2D torus";
+        case TOPO_FAT_TREE:     return "fat tree";
+        case TOPO_DRAGONFLY:    return "dragonfly";
+    }
+    return "unknown";
+}
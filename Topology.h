@@ -0,0 +1,57 @@
+/*
+ * Interconnect topologies for the Network model.
+ *
+ * A Topology numbers its directed router-to-router links densely, and routes
+ * rank => rank deterministically (dimension-order for meshes/tori, D-mod-k
+ * for fat trees, minimal for dragonflies). Hop counts only include router-to-
+ * router links, so two ranks on the same router are zero hops apart.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef enum {
+    TOPO_MESH_2D,
+    TOPO_TORUS_2D,
+    TOPO_FAT_TREE,
+    TOPO_DRAGONFLY,
+} topology_kind_t;
+
+class Topology {
+    public:
+        static Topology mesh2D(size_t width, size_t height);
+        static Topology torus2D(size_t width, size_t height);
+        static Topology fatTree(size_t radix, size_t nLevels);
+        static Topology dragonfly(size_t nGroups, size_t routersPerGroup,
+                size_t ranksPerRouter);
+
+        topology_kind_t getKind() const;
+        size_t getNRanks() const;
+        size_t getNLinks() const;
+        void route(int srcRank, int destRank,
+                std::vector<uint32_t> &links) const;
+        std::string linkName(size_t link) const;
+        static const char *name(topology_kind_t kind);
+
+    private:
+        // dims meaning, per kind:
+        //  mesh/torus: width, height
+        //  fat tree:   radix (k), nLevels (n); k^n ranks
+        //  dragonfly:  nGroups, routersPerGroup, ranksPerRouter
+        Topology(topology_kind_t kind, size_t dim0, size_t dim1, size_t dim2);
+
+        topology_kind_t kind;
+        size_t dims[3];
+        size_t nRanks, nLinks;
+        size_t nSwitchesPerLevel;   // fat tree only
+
+        void routeMesh(size_t src, size_t dest,
+                std::vector<uint32_t> &links) const;
+        void routeFatTree(size_t src, size_t dest,
+                std::vector<uint32_t> &links) const;
+        void routeDragonfly(size_t src, size_t dest,
+                std::vector<uint32_t> &links) const;
+};
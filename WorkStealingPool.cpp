@@ -0,0 +1,127 @@
+/*
+ * Implementation of the work-stealing thread pool (see WorkStealingPool.h).
+ */
+#include <assert.h>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingPool.h"
+
+// the worker (in whichever pool) running on this thread, if any
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+
+/*
+ * nThreads of 0 means one per hardware thread.
+ */
+WorkStealingPool::WorkStealingPool(size_t nThreads) : nextWorker(0),
+        nQueued(0), nSteals(0) {
+    if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+    if (nThreads == 0) nThreads = 1;
+
+    this->nUnfinished = 0;
+    this->stopping = false;
+
+    for (size_t i = 0; i < nThreads; ++i) {
+        workers.emplace_back(new worker_t());
+    }
+    for (size_t i = 0; i < nThreads; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto &t : threads) t.join();
+}
+
+void WorkStealingPool::submit(task_t task) {
+    size_t id = currentPool == this ? currentWorker :
+            nextWorker.fetch_add(1) % workers.size();
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        ++nUnfinished;
+    }
+    // count it before it's visible, or a thief could decrement nQueued first
+    nQueued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(workers[id]->lock);
+        workers[id]->tasks.push_back(std::move(task));
+    }
+
+    // take the state lock so that a worker about to sleep can't miss this
+    std::lock_guard<std::mutex> guard(stateLock);
+    workAvailable.notify_one();
+}
+
+/*
+ * Blocks until every submitted task (including ones they submit) is done.
+ * Must not be called from inside a task.
+ */
+void WorkStealingPool::wait() {
+    assert(currentPool != this);
+    std::unique_lock<std::mutex> guard(stateLock);
+    allDone.wait(guard, [this]() { return nUnfinished == 0; });
+}
+
+size_t WorkStealingPool::getNThreads() {
+    return threads.size();
+}
+
+size_t WorkStealingPool::getNSteals() {
+    return nSteals.load();
+}
+
+bool WorkStealingPool::popOwn(size_t id, task_t &task) {
+    worker_t &w = *workers[id];
+    std::lock_guard<std::mutex> guard(w.lock);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t id, task_t &task) {
+    for (size_t i = 1; i < workers.size(); ++i) {
+        worker_t &victim = *workers[(id + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        nSteals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t id) {
+    currentPool = this;
+    currentWorker = id;
+
+    task_t task;
+    while (true) {
+        if (popOwn(id, task) or steal(id, task)) {
+            nQueued.fetch_sub(1);
+            task();
+            task = nullptr;
+
+            std::lock_guard<std::mutex> guard(stateLock);
+            if (--nUnfinished == 0) allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(stateLock);
+        workAvailable.wait(guard, [this]() {
+            return stopping or nQueued.load() != 0;
+        });
+        if (stopping and nQueued.load() == 0) return;
+    }
+}
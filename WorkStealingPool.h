@@ -0,0 +1,59 @@
+/*
+ * Fixed-size thread pool with per-worker task deques and work stealing.
+ *
+ * A worker pops its own newest task first (LIFO, for locality), and when out
+ * of work steals the oldest task of another worker (FIFO, so big chunks of
+ * work move). Tasks submitted from inside a task go to the submitting
+ * worker's deque; others are dealt out round-robin. Idle workers sleep.
+ *
+ * Each deque has its own mutex, which is cheap next to the simulator-sized
+ * tasks this is meant for, and gives submit()/wait() happens-before edges,
+ * so a task may safely pick up state a previous task left behind.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+    public:
+        typedef std::function<void()> task_t;
+
+        WorkStealingPool(size_t nThreads = 0);
+        ~WorkStealingPool();
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        void submit(task_t task);
+        void wait();
+        size_t getNThreads();
+        size_t getNSteals();
+
+    private:
+        typedef struct {
+            std::mutex lock;
+            std::deque<task_t> tasks;
+        } worker_t;
+
+        std::vector<std::unique_ptr<worker_t>> workers;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> nextWorker;     // for submissions from outside
+        std::atomic<size_t> nQueued;        // submitted, not yet started
+        std::atomic<size_t> nSteals;
+
+        std::mutex stateLock;
+        std::condition_variable workAvailable, allDone;
+        size_t nUnfinished;                 // submitted, not yet finished
+        bool stopping;
+
+        void workerLoop(size_t id);
+        bool popOwn(size_t id, task_t &task);
+        bool steal(size_t id, task_t &task);
+};
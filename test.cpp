@@ -1,12 +1,31 @@
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Cache.h"
+#include "DRAM.h"
+#include "Directory.h"
+#include "L1Filter.h"
+#include "MissTrace.h"
+#include "ResultStore.h"
+#include "StackDistance.h"
+#include "SweepScheduler.h"
+#include "MultiRankSimulator.h"
+#include "WorkStealingPool.h"
+#include "StatsCollector.h"
 
 
 
@@ -228,6 +247,1637 @@ void test6() {
 }
 
 
+/*
+ * Checks that the divide-free bank reduction matches the original
+ * fold-then-mod hash, and that every hash stays within [0, nBanks).
+ */
+void test7() {
+    printf("Running %s...\n", __func__);
+
+    bank_hash_t hashes[] = { BANK_HASH_FOLD, BANK_HASH_CRC32C,
+            BANK_HASH_MULTIPLICATIVE, BANK_HASH_PAGE_INTERLEAVED };
+    size_t bankCounts[] = { 1, 7, 12, 64 };
+
+    for (size_t nBanks : bankCounts) {
+        for (bank_hash_t h : hashes) {
+            BankHasher hasher(h, nBanks, 6);
+            for (uint64_t line = 0; line < 100000; line += 7) {
+                uint64_t lineAddr = line * 0x10001 + (line << 40);
+                uint32_t bank = hasher.hash(lineAddr);
+                assert(bank < nBanks);
+
+                if (h == BANK_HASH_FOLD) {
+                    uint32_t res = 0;
+                    uint64_t tmp = lineAddr;
+                    for (uint32_t i = 0; i < 4; i++) {
+                        res ^= (uint32_t) (0xffff & tmp);
+                        tmp = tmp >> 16;
+                    }
+                    assert(bank == res % nBanks);
+                }
+            }
+        }
+    }
+
+    // 64 lines per 4KiB page => 64 consecutive lines share a bank
+    BankHasher pageHasher(BANK_HASH_PAGE_INTERLEAVED, 8, 6);
+    assert(pageHasher.hash(63) == 0);
+    assert(pageHasher.hash(64) == 1);
+    assert(pageHasher.hash(8 * 64) == 0);
+
+    printf("%s complete.\n", __func__);
+}
+
+/*
+ * A 16-line stride sends every access to bank 0 under fold-and-mask; the
+ * multiplicative hash should spread the same stream across all banks.
+ */
+void test8() {
+    printf("Running %s...\n", __func__);
+
+    size_t nBanks = 16;
+    size_t nAccesses = 4096;
+    size_t lineSize = 64;
+
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly, hash */
+    auto folded = LRUSimpleCache(65536, 8, nBanks, lineSize, false,
+            BANK_HASH_FOLD_MASK);
+    auto mult = LRUSimpleCache(65536, 8, nBanks, lineSize, false,
+            BANK_HASH_MULTIPLICATIVE);
+
+    for (size_t i = 0; i < nAccesses; ++i) {
+        intptr_t addr = i * 16 * lineSize;
+        folded.access(addr, false);
+        mult.access(addr, false);
+    }
+
+    folded.computeStats();
+    mult.computeStats();
+    assert(folded.getBankAccesses()[0] == nAccesses);
+    assert(folded.getStats()->bankImbalance == double(nBanks));
+    assert(mult.getStats()->bankImbalance < 1.5);
+
+    size_t total = 0;
+    for (size_t n : mult.getBankAccesses()) total += n;
+    assert(total == nAccesses);
+
+    mult.dumpTextStats(stderr);
+    printf("%s complete.\n", __func__);
+}
+
+
+#ifdef CACHESIM_SET_STATS
+/*
+ * Thrashes a single set with 3 lines in 2 ways, and checks that the conflict
+ * shows up in that set (and only that set) of the dumped heatmap.
+ */
+void test9() {
+    printf("Running %s...\n", __func__);
+
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(64, 2, 1, 64, false);
+    size_t nSets = 32;
+    size_t lineSize = 64;
+
+    for (size_t pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < 3; ++i) {
+            c.access(i * nSets * lineSize, false);
+        }
+    }
+    c.access(lineSize, false);  // set 1
+    c.access(lineSize, false);
+
+    const char *path = "/tmp/cachesim_test9.heatmap";
+    c.dumpSetStats(path);
+
+    FILE *f = fopen(path, "rb");
+    char magic[4];
+    uint32_t version;
+    uint64_t dims[2];
+    assert(fread(magic, sizeof(magic), 1, f) == 1);
+    assert(fread(&version, sizeof(version), 1, f) == 1);
+    assert(fread(dims, sizeof(dims), 1, f) == 1);
+    assert(memcmp(magic, "CSSH", 4) == 0 and version == 1);
+    assert(dims[0] == 1 and dims[1] == nSets);
+
+    std::vector<set_stats_t> sets(nSets);
+    assert(fread(sets.data(), sizeof(set_stats_t), nSets, f) == nSets);
+    fclose(f);
+    remove(path);
+
+    assert(sets[0].hits == 0);
+    assert(sets[0].misses == 6);
+    assert(sets[0].evictions == 4);
+    assert(sets[1].hits == 1 and sets[1].misses == 1);
+    assert(sets[1].evictions == 0);
+
+    c.dumpTextStats(stderr);
+    printf("%s complete.\n", __func__);
+}
+#endif
+
+
+/*
+ * Cross-checks FullyAssocLRU against a straightforward map + list LRU over a
+ * random stream, including non-allocating touches.
+ */
+void test10() {
+    printf("Running %s...\n", __func__);
+
+    size_t capacity = 37;
+    FullyAssocLRU fa(capacity);
+    map_t map;
+    list_t list;
+
+    srand(10);
+    for (size_t i = 0; i < 200000; ++i) {
+        line_addr_t line = rand() % 100;
+        bool allocate = rand() % 4 != 0;
+
+        bool evicted;
+        uint64_t evictedLine;
+        bool wasHit = fa.touch(line, allocate, evicted, evictedLine);
+
+        bool refHit = map.count(line) != 0;
+        bool refEvicted = false;
+        line_addr_t refEvictedLine = 0;
+        if (refHit) {
+            list.erase(map[line]);
+            map.erase(line);
+        }
+        else if (allocate and map.size() == capacity) {
+            refEvicted = true;
+            refEvictedLine = list.front();
+            map.erase(list.front());
+            list.pop_front();
+        }
+        if (refHit or allocate) {
+            list.emplace_back(line);
+            map.emplace(line, std::prev(list.end()));
+        }
+
+        assert(wasHit == refHit);
+        assert(evicted == refEvicted);
+        if (evicted) assert(evictedLine == refEvictedLine);
+        assert(fa.size() == map.size());
+    }
+
+    printf("%s complete.\n", __func__);
+}
+
+/*
+ * Builds a stream with known compulsory, conflict, and capacity misses, and
+ * checks the 3C split for both LRUSimpleCache and LRUCache.
+ */
+void test11() {
+    printf("Running %s...\n", __func__);
+
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(64, 2, 1, 64, false);
+    c.enableMissClassification();
+    size_t nSets = 32;
+    size_t lineSize = 64;
+
+    // 3 lines in a 2-way set: 3 compulsory, then 3 conflict misses
+    for (size_t pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < 3; ++i) {
+            c.access(i * nSets * lineSize, false);
+        }
+    }
+    auto s = c.getStats();
+    assert(s->RMByClass[MISS_COMPULSORY] == 3);
+    assert(s->RMByClass[MISS_CONFLICT] == 3);
+    assert(s->RMByClass[MISS_CAPACITY] == 0);
+
+    // cycling over 2X the capacity misses even when fully associative
+    c.zeroStatsCounters();
+    for (size_t pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < 128; ++i) {
+            c.access((1000 + i) * lineSize, true);
+        }
+    }
+    assert(s->WM == 256);
+    assert(s->WMByClass[MISS_COMPULSORY] == 128);
+    assert(s->WMByClass[MISS_CAPACITY] == 128);
+    c.dumpTextStats(stderr);
+
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes) */
+    auto c2 = LRUCache(16, 2, 64, 2, 1, 64);
+    c2.enableMissClassification();
+    srand(11);
+    for (size_t i = 0; i < 10000; ++i) {
+        c2.access((rand() % 256) * lineSize, rand() % 2);
+    }
+    auto s2 = c2.getStats();
+    size_t nRM = 0, nWM = 0;
+    for (int mc = 0; mc < N_MISS_CLASSES; ++mc) {
+        nRM += s2->L2RMByClass[mc];
+        nWM += s2->L2WMByClass[mc];
+    }
+    assert(nRM == s2->L2RM and nWM == s2->L2WM);
+    assert(s2->L2RMByClass[MISS_COMPULSORY] + s2->L2WMByClass[MISS_COMPULSORY]
+            == 256);
+    c2.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+/*
+ * Checks FootprintBitmap's first-touch answers and footprints at several
+ * granularities against a set of touched lines, including sparse and
+ * kernel-half addresses.
+ */
+void test12() {
+    printf("Running %s...\n", __func__);
+
+    size_t lineSizeLog2 = 6;
+    FootprintBitmap fp(lineSizeLog2);
+    std::unordered_set<uint64_t> ref;
+
+    srand(12);
+    for (size_t i = 0; i < 100000; ++i) {
+        uintptr_t addr;
+        switch (rand() % 3) {
+            case 0:  addr = rand() % (1 << 24); break;          // dense
+            case 1:  addr = (uintptr_t) rand() << 20; break;    // sparse
+            default: addr = 0xffff800000000000ULL + rand(); break;
+        }
+        bool first = fp.access(addr);
+        assert(first == ref.insert(addr >> lineSizeLog2).second);
+    }
+    assert(fp.getNLinesTouched() == ref.size());
+    assert(fp.contains(0xffff800000000000ULL >> lineSizeLog2) ==
+            (ref.count(0xffff800000000000ULL >> lineSizeLog2) != 0));
+
+    size_t granules[] = { 64, 128, 512, 4096, 8192, 1 << 21, 1 << 22 };
+    for (size_t g : granules) {
+        std::unordered_set<uint64_t> refGranules;
+        for (uint64_t line : ref) refGranules.insert((line << 6) / g);
+        assert(fp.footprint(g) == refGranules.size());
+        assert(fp.footprintBytes(g) == refGranules.size() * g);
+    }
+
+    printf("%s complete.\n", __func__);
+}
+
+
+/*
+ * Highly-associative sets go through the FullyAssocLRU engine; check them
+ * against a per-set map + list reference, then check a 1M-entry fully-
+ * associative cache.
+ */
+void test13() {
+    printf("Running %s...\n", __func__);
+
+    size_t nLines = 1024, nWays = 128, lineSize = 64;
+    size_t nSets = nLines / nWays;
+
+    for (int allocateOnWritesOnly = 0; allocateOnWritesOnly < 2;
+            ++allocateOnWritesOnly) {
+        /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+        auto c = LRUSimpleCache(nLines, nWays, 1, lineSize,
+                allocateOnWritesOnly);
+        std::vector<map_t> maps(nSets);
+        std::vector<list_t> lists(nSets);
+        size_t RH = 0, RM = 0, WH = 0, WM = 0, nE = 0;
+
+        srand(13);
+        for (size_t i = 0; i < 200000; ++i) {
+            line_addr_t line = rand() % 2048;
+            bool isWrite = rand() % 2;
+            c.access(line * lineSize, isWrite);
+
+            map_t &map = maps[line % nSets];
+            list_t &list = lists[line % nSets];
+            bool hit = map.count(line) != 0;
+            bool allocate = !allocateOnWritesOnly or isWrite;
+            if (hit) {
+                list.erase(map[line]);
+                map.erase(line);
+            }
+            else if (allocate and map.size() == nWays) {
+                map.erase(list.front());
+                list.pop_front();
+                ++nE;
+            }
+            if (hit or allocate) {
+                list.emplace_back(line);
+                map.emplace(line, std::prev(list.end()));
+            }
+            if (!isWrite) hit ? ++RH : ++RM;
+            else          hit ? ++WH : ++WM;
+        }
+
+        auto s = c.getStats();
+        assert(s->RH == RH and s->RM == RM);
+        assert(s->WH == WH and s->WM == WM);
+        assert(s->nE == nE);
+    }
+
+    // fully associative, TLB/page-cache scale
+    size_t nEntries = 1048576;
+    auto fa = LRUSimpleCache(nEntries, nEntries, 1, lineSize, false);
+    for (size_t pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < nEntries; ++i) {
+            fa.access(i * 7 * lineSize, false);
+        }
+    }
+    fa.access(nEntries * 7 * lineSize, false);    // evicts line 0
+    fa.access(0, false);
+    auto s = fa.getStats();
+    assert(s->RM == nEntries + 2);
+    assert(s->RH == nEntries);
+    assert(s->nE == 2);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+/*
+ * Checks hop counts for each topology, and that a Network with a topology
+ * accumulates per-link bytes and byte-hops.
+ */
+void test14() {
+    printf("Running %s...\n", __func__);
+
+    std::vector<uint32_t> route;
+
+    Topology mesh = Topology::mesh2D(4, 4);
+    for (int src = 0; src < 16; ++src) {
+        for (int dest = 0; dest < 16; ++dest) {
+            mesh.route(src, dest, route);
+            size_t hops = abs(src % 4 - dest % 4) + abs(src / 4 - dest / 4);
+            assert(route.size() == hops);
+        }
+    }
+
+    Topology torus = Topology::torus2D(4, 4);
+    torus.route(0, 15, route);
+    assert(route.size() == 2);      // wraps in both dimensions
+
+    Topology fatTree = Topology::fatTree(4, 3);     // 64 ranks
+    assert(fatTree.getNRanks() == 64);
+    fatTree.route(0, 1, route);
+    assert(route.size() == 0);      // same leaf switch
+    fatTree.route(0, 4, route);
+    assert(route.size() == 2);
+    fatTree.route(0, 63, route);
+    assert(route.size() == 4);
+    for (uint32_t link : route) assert(link < fatTree.getNLinks());
+
+    Topology dragonfly = Topology::dragonfly(5, 4, 2);  // 40 ranks
+    dragonfly.route(0, 1, route);
+    assert(route.size() == 0);      // same router
+    dragonfly.route(0, 2, route);
+    assert(route.size() == 1);      // same group
+    for (int dest = 8; dest < 40; ++dest) {
+        dragonfly.route(0, dest, route);
+        assert(route.size() >= 1 and route.size() <= 3);
+        assert(route.back() < dragonfly.getNLinks());
+    }
+
+    Network n(0);
+    n.setTopology(&mesh);
+    n.sendTo(15, 100);      // 6 hops
+    n.sendTo(1, 10);        // 1 hop, over the same first link
+    assert(n.getByteHops() == 610);
+    assert(n.getLinkBytes()[0 * 4 + 0] == 110);     // (0,0)+x
+    n.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+/*
+ * Checks Network's dense per-destination byte/message counters, sendToBatch(),
+ * and the message-size histogram.
+ */
+void test15() {
+    printf("Running %s...\n", __func__);
+
+    int worldSize = 8;
+    Network single(0, worldSize), batched(0, worldSize);
+
+    std::vector<int> dests;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < 1000; ++i) {
+        dests.push_back(i % worldSize);
+        sizes.push_back(i + 1);
+        single.sendTo(i % worldSize, i + 1);
+    }
+    batched.sendToBatch(dests.data(), sizes.data(), dests.size());
+
+    for (int d = 0; d < worldSize; ++d) {
+        assert(single.getBytesTo(d) == batched.getBytesTo(d));
+        assert(batched.getMsgsTo(d) == size_t(1000 / worldSize));
+    }
+    assert(batched.getBytesTo(0) == 62125);     // 1 + 9 + ... + 993
+
+    // sizes 1..1000: percentiles to within a sub-bucket (1/8)
+    const Histogram &h = batched.getMsgSizeHistogram();
+    assert(h.getCount() == 1000 and h.getMax() == 1000);
+    assert(h.percentile(50) <= 500 and h.percentile(50) >= 500 * 7 / 8);
+    assert(h.percentile(99) <= 990 and h.percentile(99) >= 990 * 7 / 8);
+
+    // destinations beyond the declared world size still get counted
+    batched.sendTo(20, 64);
+    assert(batched.getNDests() == 21 and batched.getBytesTo(20) == 64);
+    assert(batched.getBytesTo(100) == 0);
+
+    batched.zeroStatsCounters();
+    assert(batched.getMsgsTo(0) == 0 and h.getCount() == 0);
+    single.dumpTextStats(stderr);
+
+    // the top bucket's bounds print without overflowing
+    Histogram top;
+    top.record(UINT64_MAX);
+    FILE *f = tmpfile();
+    top.dumpText(f, "");
+    rewind(f);
+    char line[128], bucket[128];
+    assert(fgets(line, sizeof(line), f) and fgets(bucket, sizeof(bucket), f));
+    fclose(f);
+    assert(strcmp(bucket, "[17293822569102704640,18446744073709551615]\t1\n")
+            == 0);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+/*
+ * Checks the time-windowed traffic matrix, stamped both explicitly and by a
+ * companion cache's access counter, and its binary dump.
+ */
+void test16() {
+    printf("Running %s...\n", __func__);
+
+    Network n(0, 4);
+    n.enableTimeWindows(100);
+    n.sendTo(1, 10, 5);
+    n.sendTo(2, 20, 150);
+    n.sendTo(2, 5, 160);
+    n.sendTo(3, 7, 420);
+    n.sendTo(1, 1, 50);     // back in window 0
+
+    const char *path = "/tmp/cachesim_test16.tw";
+    n.dumpTimeSeries(path);
+
+    FILE *f = fopen(path, "rb");
+    char magic[4];
+    uint32_t version;
+    int64_t rank;
+    uint64_t header[3];
+    assert(fread(magic, sizeof(magic), 1, f) == 1);
+    assert(fread(&version, sizeof(version), 1, f) == 1);
+    assert(fread(&rank, sizeof(rank), 1, f) == 1);
+    assert(fread(header, sizeof(header), 1, f) == 1);
+    assert(memcmp(magic, "CSTW", 4) == 0 and version == 2 and rank == 0);
+    assert(header[0] == 100 and header[1] == 3 and header[2] == 4);
+
+    // only windows 0, 1 and 4 had traffic: (window, 4 dests) per row
+    std::vector<uint64_t> matrix(3 * 5);
+    assert(fread(matrix.data(), sizeof(uint64_t), matrix.size(), f) ==
+            matrix.size());
+    fclose(f);
+    remove(path);
+
+    assert(matrix[0 * 5] == 0 and matrix[0 * 5 + 1 + 1] == 11);
+    assert(matrix[1 * 5] == 1 and matrix[1 * 5 + 1 + 2] == 25);
+    assert(matrix[2 * 5] == 4 and matrix[2 * 5 + 1 + 3] == 7);
+    uint64_t total = 0;
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        if (i % 5 != 0) total += matrix[i];
+    }
+    assert(total == 43);
+    n.dumpTextStats(stderr);
+
+    // far-apart timestamps don't allocate the windows in between, and the
+    // peak/mean ratio ignores bytes sent before windowing started
+    Network sparse(0, 2);
+    sparse.sendTo(1, 1000);
+    sparse.enableTimeWindows(100);
+    sparse.sendTo(1, 10, 0);
+    sparse.sendTo(1, 30, 300);
+    FILE *text = tmpfile();
+    sparse.dumpTextStats(text);
+    rewind(text);
+    char line[256];
+    bool sawWindows = false;
+    while (fgets(line, sizeof(line), text)) {
+        if (strncmp(line, "Windows:", 8) != 0) continue;
+        assert(strstr(line, "peak window 3: 30 bytes (3.00x mean)"));
+        sawWindows = true;
+    }
+    fclose(text);
+    assert(sawWindows);
+    sparse.sendTo(1, 5, uint64_t(1) << 62);
+    sparse.dumpTimeSeries(path);
+    f = fopen(path, "rb");
+    fseek(f, 4 + 4 + 8, SEEK_SET);
+    assert(fread(header, sizeof(header), 1, f) == 1);
+    fclose(f);
+    remove(path);
+    assert(header[1] == 3);
+
+    // windows of 10 accesses, clocked by a cache
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(64, 4, 1, 64, false);
+    Network clocked(0, 2);
+    clocked.enableTimeWindows(10);
+    clocked.setWindowClock(c.getAccessCounter());
+    for (size_t i = 0; i < 25; ++i) c.access(i * 64, false);
+    clocked.sendTo(1, 64);
+
+    clocked.dumpTimeSeries(path);
+    f = fopen(path, "rb");
+    fseek(f, 4 + 4 + 8, SEEK_SET);
+    assert(fread(header, sizeof(header), 1, f) == 1);
+    uint64_t window;
+    assert(fread(&window, sizeof(window), 1, f) == 1);
+    fclose(f);
+    remove(path);
+    assert(header[1] == 1 and window == 2);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test17() {
+    printf("Running %s...\n", __func__);
+
+    // 4 ranks (threads standing in for processes) on 2 "nodes"
+    const size_t worldSize = 4;
+    std::vector<std::string> paths = { "/tmp/cachesim_test17.node0",
+            "/tmp/cachesim_test17.node1" };
+    for (auto &p : paths) StatsCollector::removeSegment(p.c_str());
+
+    std::vector<std::thread> ranks;
+    for (size_t r = 0; r < worldSize; ++r) {
+        ranks.emplace_back([r, &paths]() {
+            StatsCollector collector(paths[r / 2].c_str(), worldSize, 2, 1);
+            /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+            auto c = LRUSimpleCache(16, 4, 1, 64, false);
+            Network n(r, worldSize);
+
+            for (size_t i = 0; i < 32 * (r + 1); ++i) {
+                c.access((i % 32) * 64, i & 1);
+            }
+            for (size_t dest = 0; dest < worldSize; ++dest) {
+                n.sendTo(dest, 100 * r + dest);
+            }
+            collector.publish(r, *c.getStats(), n);
+
+            // re-publishing replaces, rather than adds to, our slot
+            n.sendTo((r + 1) % worldSize, 1000);
+            c.computeStats();
+            collector.publish(r, *c.getStats(), n);
+        });
+    }
+    for (auto &t : ranks) t.join();
+
+    StatsCollector::merged_t merged;
+    StatsCollector::merge(paths, merged);
+    assert(merged.worldSize == worldSize and merged.nRanksPublished == 4);
+
+    size_t nAccesses = 0;
+    for (size_t r = 0; r < worldSize; ++r) {
+        nAccesses += 32 * (r + 1);
+        for (size_t dest = 0; dest < worldSize; ++dest) {
+            uint64_t expected = 100 * r + dest +
+                    (dest == (r + 1) % worldSize ? 1000 : 0);
+            assert(merged.trafficMatrix[r * worldSize + dest] == expected);
+        }
+    }
+    const SimpleCache::stats_t &s = merged.stats;
+    assert(s.RH + s.RM + s.WH + s.WM == nAccesses);
+    // every rank's footprint is 32 lines, twice its 16-line cache
+    assert(s.RM + s.WM == nAccesses);
+    assert(s.RHP == 0.0 and s.RMP == 1.0 and s.WMP == 1.0);
+    StatsCollector::dumpTextStats(stderr, merged);
+
+    const char *matrixPath = "/tmp/cachesim_test17.tm";
+    StatsCollector::dumpTrafficMatrix(matrixPath, merged.trafficMatrix,
+            worldSize);
+    FILE *f = fopen(matrixPath, "rb");
+    char magic[4];
+    uint32_t version;
+    uint64_t n;
+    assert(fread(magic, sizeof(magic), 1, f) == 1);
+    assert(fread(&version, sizeof(version), 1, f) == 1);
+    assert(fread(&n, sizeof(n), 1, f) == 1);
+    assert(memcmp(magic, "CSTM", 4) == 0 and version == 1 and n == worldSize);
+    std::vector<uint64_t> matrix(worldSize * worldSize);
+    assert(fread(matrix.data(), sizeof(uint64_t), matrix.size(), f) ==
+            matrix.size());
+    fclose(f);
+    assert(matrix == merged.trafficMatrix);
+
+    // a rerun (new runID) over the same segment doesn't see the old results
+    {
+        StatsCollector collector(paths[0].c_str(), worldSize, 2, 2);
+        auto c = LRUSimpleCache(16, 4, 1, 64, false);
+        Network n(1, worldSize);
+        c.access(0, false);
+        n.sendTo(0, 7);
+        collector.publish(1, *c.getStats(), n);
+    }
+    StatsCollector::merge({ paths[0] }, merged);
+    assert(merged.nRanksPublished == 1);
+    assert(merged.stats.RM == 1 and merged.stats.RH + merged.stats.WH +
+            merged.stats.WM == 0);
+    for (size_t i = 0; i < merged.trafficMatrix.size(); ++i) {
+        assert(merged.trafficMatrix[i] == (i == 1 * worldSize + 0 ? 7 : 0));
+    }
+
+    // a missing, empty, truncated or corrupt file throws instead of being
+    // read past its end
+    std::ifstream in(paths[0], std::ios::in | std::ios::binary);
+    std::string segment((std::istreambuf_iterator<char>(in)),
+            std::istreambuf_iterator<char>());
+    in.close();
+    std::string badRank = segment;
+    int64_t rank = worldSize;
+    memcpy(&badRank[5 * 8 + 8], &rank, sizeof(rank));  // slot 0's rank
+    const char *badPath = "/tmp/cachesim_test17.bad";
+    std::vector<std::string> bad = { "", segment.substr(0, 20),
+            segment.substr(0, segment.size() - 8), badRank,
+            std::string(segment.size(), 'x') };
+    for (size_t i = 0; i <= bad.size(); ++i) {
+        std::string badFile = i == 0 ? "/nonexistent/cachesim_test17" :
+                badPath;
+        if (i != 0) {
+            std::ofstream of(badPath, std::ios::out | std::ios::binary);
+            of.write(bad[i - 1].data(), bad[i - 1].size());
+        }
+        bool threw = false;
+        try {
+            StatsCollector::merge({ badFile }, merged);
+        }
+        catch (const std::system_error &e) {
+            threw = e.code() == std::errc::invalid_argument or i == 0;
+        }
+        assert(threw);
+    }
+    remove(badPath);
+
+    remove(matrixPath);
+    for (auto &p : paths) StatsCollector::removeSegment(p.c_str());
+    StatsCollector::removeSegment(paths[0].c_str());    // already gone
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test18() {
+    printf("Running %s...\n", __func__);
+
+    // 1 byte/cycle, 10 cycles/hop, no topology (just our injection link)
+    Network n(0, 2);
+    n.enableTimeWindows(100);
+    n.enableTimingModel(1.0, 10);
+    assert(n.getInjectionLink() == 0);
+    n.sendTo(1, 50, 0);         // 10 + 50
+    n.sendTo(1, 50, 0);         // queues behind the first for 50 cycles
+    n.sendTo(1, 150, 180);      // busy over [180, 330)
+    n.sendTo(1, 50, 1000);
+
+    const Histogram &lat = n.getLatencyHistogram();
+    assert(lat.getCount() == 4);
+    assert(lat.getSum() == 60 + 110 + 160 + 60);
+    assert(lat.getMax() == 160 and lat.percentile(50) == 60);
+    assert(n.getQueueingHistogram().getSum() == 50);
+
+    assert(n.getLinkUtilization(0, 0) == 1.0);
+    assert(n.getLinkUtilization(0, 1) == 0.2);
+    assert(n.getLinkUtilization(0, 2) == 1.0);
+    assert(n.getLinkUtilization(0, 3) == 0.3);
+    assert(n.getLinkUtilization(0, 4) == 0.0);
+    assert(n.getLinkUtilization(0, 10) == 0.5);
+
+    const char *path = "/tmp/cachesim_test18.lu";
+    n.dumpLinkUtilization(path);
+    FILE *f = fopen(path, "rb");
+    char magic[4];
+    uint32_t version;
+    assert(fread(magic, sizeof(magic), 1, f) == 1);
+    assert(fread(&version, sizeof(version), 1, f) == 1);
+    assert(memcmp(magic, "CSLU", 4) == 0 and version == 2);
+    fseek(f, 8, SEEK_CUR);
+    // only the windows with busy links (0-3 and 10) get a row
+    uint64_t header[3];
+    assert(fread(header, sizeof(header), 1, f) == 1);
+    assert(header[0] == 100 and header[1] == 5 and header[2] == 1);
+    uint64_t rows[5][2];
+    assert(fread(rows, sizeof(rows), 1, f) == 1);
+    assert(rows[0][0] == 0 and rows[0][1] == 100);
+    assert(rows[3][0] == 3 and rows[3][1] == 30);
+    assert(rows[4][0] == 10 and rows[4][1] == 50);
+    fclose(f);
+    remove(path);
+
+    // over a 2x2 mesh: 0 => 3 is 2 hops, 0 => 1 is 1 hop
+    Topology mesh = Topology::mesh2D(2, 2);
+    Network m(0, 4);
+    m.setTopology(&mesh);
+    m.enableTimingModel(2.0, 10, 5);
+    assert(m.getInjectionLink() == mesh.getNLinks());
+    m.sendTo(3, 64, 0);         // 5 + 3 * 10 + 32
+    m.sendTo(1, 64, 0);         // waits 32 for the injection link
+    assert(m.getLatencyHistogram().getSum() == 67 + (5 + 32 + 2 * 10 + 32));
+    assert(m.getQueueingHistogram().getMax() == 32);
+    m.dumpTextStats(stderr);
+
+    // without a timestamp or window clock, sends are counted but not timed
+    Network u(0, 2);
+    u.enableTimingModel(1.0, 10);
+    for (size_t i = 0; i < 3; ++i) u.sendTo(1, 50);
+    assert(u.getNUntimedMsgs() == 3 and u.getMsgsTo(1) == 3);
+    assert(u.getLatencyHistogram().getCount() == 0);
+    uint64_t clock = 0;
+    u.setWindowClock(&clock);
+    u.sendTo(1, 50);
+    assert(u.getNUntimedMsgs() == 3);
+    assert(u.getLatencyHistogram().getSum() == 60);
+
+    // a cache's remote traffic is sent at its accesses' timestamps
+    HomeMap home = HomeMap::pageInterleaved(2);
+    Network r(0, 2);
+    r.enableTimingModel(1.0, 10);
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(4, 4, 1, 64, false);
+    c.attachNetwork(&r, &home, 50);
+    c.access(4096, false, 0);
+    c.access(8192 + 4096, false, 1000);
+    assert(r.getNUntimedMsgs() == 0);
+    assert(r.getLatencyHistogram().getSum() == 60 + 60);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test19() {
+    printf("Running %s...\n", __func__);
+
+    HomeMap blocks = HomeMap::blockCyclic(4, 100, 1000);
+    assert(blocks.home(1000) == 0 and blocks.home(1099) == 0);
+    assert(blocks.home(1100) == 1 and blocks.home(1400) == 0);
+
+    HomeMap pages = HomeMap::pageInterleaved(3);
+    assert(pages.home(4095) == 0 and pages.home(4096) == 1);
+    assert(pages.home(3 * 4096) == 0);
+
+    HomeMap table = HomeMap::rangeTable(7);
+    table.addRange(0x3000, 0x4000, 2);
+    table.addRange(0x1000, 0x2000, 1);
+    assert(table.home(0x500) == 7 and table.home(0x1800) == 1);
+    assert(table.home(0x2000) == 7 and table.home(0x3fff) == 2);
+    assert(table.home(0x4000) == 7);
+
+    // rank 0 of 2; odd pages live on rank 1
+    HomeMap home = HomeMap::pageInterleaved(2);
+    Network n(0, 2);
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(4, 4, 1, 64, false);
+    c.attachNetwork(&n, &home);
+
+    c.access(4096, false);      // remote miss: request + line
+    c.access(4096, true);       // hit; now dirty
+    c.access(0, false);         // local lines, up to evicting 4096
+    c.access(64, false);
+    c.access(128, false);
+    c.access(192, false);       // evicts 4096: writeback
+    c.access(4096 + 64, false); // remote miss; evicts (local) 0
+
+    assert(n.getMsgsTo(1) == 3 and n.getBytesTo(1) == 8 + 64 + 8);
+    assert(n.getBytesFrom(1) == 2 * 64);
+    assert(n.getBytesTo(0) == 0 and n.getBytesFrom(0) == 0);
+    assert(c.getStats()->remoteMisses == 2);
+    assert(c.getStats()->remoteWritebacks == 1);
+    c.dumpTextStats(stderr);
+    n.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test20() {
+    printf("Running %s...\n", __func__);
+
+    // 3 nodes; page p lives on node p % 3; 4-line fully-associative caches
+    HomeMap pages = HomeMap::pageInterleaved(3);
+    Directory d(3, &pages, 4, 4, 64);
+    const uintptr_t A = 2 * 4096;   // homed on node 2
+
+    d.access(0, A, false);          // 0 => 2 req, 2 => 0 data
+    d.access(1, A, false);          // 1 => 2 req, 2 => 1 data
+    assert(d.getNSharers(A) == 2 and d.getOwner(A) == -1);
+    d.access(0, A, true);           // upgrade: inval 1 (acks 0), grant 0
+    assert(d.getNSharers(A) == 1 and d.getOwner(A) == 0);
+    d.access(0, A, true);           // M hit: silent
+    d.access(1, A, false);          // forwarded to 0, which writes back
+    assert(d.getNSharers(A) == 2 and d.getOwner(A) == -1);
+
+    Directory::stats_t *s = d.getStats();
+    assert(s->nRequests == 3 and s->nUpgrades == 1 and s->nForwards == 1);
+    assert(s->nInvalidations == 1 and s->nSpuriousInvalidations == 0);
+    assert(s->nWritebacks == 1);
+    assert(d.getCache(1).getStats()->RM == 2);
+
+    assert(d.getNetwork(0).getBytesTo(2) == 8 + 8 + 64);
+    assert(d.getNetwork(0).getBytesTo(1) == 64);
+    assert(d.getNetwork(1).getBytesTo(2) == 8 + 8);
+    assert(d.getNetwork(1).getBytesTo(0) == 8);
+    assert(d.getNetwork(2).getBytesTo(0) == 64 + 8 + 8);
+    assert(d.getNetwork(2).getBytesTo(1) == 64 + 8);
+
+    // evicting A everywhere frees its entry (local lines are free to send)
+    for (uintptr_t i = 0; i < 4; ++i) d.access(1, 4096 + i * 64, false);
+    assert(d.getNSharers(A) == 1);
+    for (uintptr_t i = 0; i < 4; ++i) d.access(0, i * 64, false);
+    assert(d.getNSharers(A) == 0 and d.getNEntries() == 8);
+    assert(s->nReplacementHints == 2);
+    assert(d.getNetwork(1).getBytesTo(2) == 8 + 8 + 8);
+    d.dumpTextStats(stderr);
+
+    // coarse vectors: 130 nodes => 3 nodes per sharer bit
+    HomeMap lines = HomeMap::blockCyclic(130, 64);
+    Directory coarse(130, &lines, 16, 16, 64);
+    const uintptr_t B = 129 * 64;   // homed on node 129
+    coarse.access(0, B, false);
+    coarse.access(5, B, false);
+    coarse.access(100, B, true);    // invalidates nodes 0-2 and 3-5
+    s = coarse.getStats();
+    assert(s->nInvalidations == 6 and s->nSpuriousInvalidations == 4);
+    assert(coarse.getNSharers(B) == 1 and coarse.getOwner(B) == 100);
+    assert(!coarse.getCache(0).containsLine(129));
+    assert(!coarse.getCache(5).containsLine(129));
+    assert(coarse.getNetwork(129).getBytesTo(4) == 8);
+
+    // invalidation in the fully-associative engine recycles the way
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto fa = LRUSimpleCache(128, 128, 1, 64, false);
+    for (uintptr_t i = 0; i < 128; ++i) fa.access(i * 64, false);
+    assert(fa.invalidateLine(7) and !fa.containsLine(7));
+    assert(!fa.invalidateLine(7));
+    fa.access(1000 * 64, false);    // takes the freed way: no eviction
+    assert(fa.getStats()->nE == 0 and fa.containsLine(0));
+    fa.access(1001 * 64, false);    // full again: evicts line 0 (LRU)
+    assert(fa.getStats()->nE == 1 and !fa.containsLine(0));
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test21() {
+    printf("Running %s...\n", __func__);
+
+    // tasks that spawn tasks
+    WorkStealingPool pool(4);
+    std::atomic<size_t> sum(0);
+    for (size_t i = 0; i < 100; ++i) {
+        pool.submit([&pool, &sum, i]() {
+            for (size_t j = 0; j < 10; ++j) {
+                pool.submit([&sum, i, j]() { sum += i * 10 + j; });
+            }
+        });
+    }
+    pool.wait();
+    assert(sum == 999 * 1000 / 2);
+
+    // 16 ranks with uneven traces, each checked against a serial replay
+    const size_t nRanks = 16;
+    std::vector<std::vector<trace_record_t>> traces(nRanks);
+    srand(21);
+    for (size_t r = 0; r < nRanks; ++r) {
+        size_t n = 1000 * (r % 4 + 1);
+        for (size_t i = 0; i < n; ++i) {
+            trace_record_t rec;
+            if (rand() % 10 == 0) {
+                rec.op = TRACE_SEND;
+                rec.addr = rand() % nRanks;
+                rec.nBytes = 1 + rand() % 100;
+            }
+            else {
+                rec.op = rand() % 3 == 0 ? TRACE_WRITE : TRACE_READ;
+                rec.addr = (rand() % 512) * 64;
+                rec.nBytes = 0;
+            }
+            traces[r].push_back(rec);
+        }
+    }
+
+    /* nRanks, nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    MultiRankSimulator sim(nRanks, 128, 4, 2, 64, false, 8);
+    for (size_t r = 0; r < nRanks; ++r) {
+        sim.setTrace(r, traces[r].data(), traces[r].size());
+    }
+    sim.run(pool, 100);
+
+    StatsCollector::merged_t merged;
+    sim.merge(merged);
+    size_t nAccesses = 0;
+    for (size_t r = 0; r < nRanks; ++r) {
+        auto c = LRUSimpleCache(128, 4, 2, 64, false);
+        Network n(r, nRanks);
+        for (auto &rec : traces[r]) {
+            if (rec.op == TRACE_SEND) n.sendTo(rec.addr, rec.nBytes);
+            else c.access(rec.addr, rec.op == TRACE_WRITE);
+        }
+        SimpleCache::stats_t *expected = c.getStats();
+        SimpleCache::stats_t *got = sim.getCache(r).getStats();
+        assert(got->RH == expected->RH and got->RM == expected->RM);
+        assert(got->WH == expected->WH and got->WM == expected->WM);
+        assert(got->nE == expected->nE);
+        for (size_t dest = 0; dest < nRanks; ++dest) {
+            assert(merged.trafficMatrix[r * nRanks + dest] ==
+                    n.getBytesTo(dest));
+        }
+        nAccesses += expected->RH + expected->RM + expected->WH + expected->WM;
+        assert(sim.getHistogramCounter(r) != nullptr);
+    }
+    assert(merged.stats.RH + merged.stats.RM + merged.stats.WH +
+            merged.stats.WM == nAccesses);
+    StatsCollector::dumpTextStats(stderr, merged);
+    fprintf(stderr, "Steals: %zu\n", pool.getNSteals());
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test22() {
+    printf("Running %s...\n", __func__);
+
+    // 4 L2 banks on a 2x2 grid (page p => bank p % 4); 1-line L1
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache c(1, 1, 64, 4, 4, 64, BANK_HASH_PAGE_INTERLEAVED);
+    c.enableNUCA(2, 2, 10, 2);
+    c.setCorePosition(1, 1, 1);
+    const uintptr_t A = 0, B = 3 * 4096;    // banks 0 (0,0) and 3 (1,1)
+
+    c.access(A, false);         // L2 misses
+    c.access(B, false);
+    c.access(A, false);         // L2 hits: 10 cycles, then 10 + 2 * 2
+    c.access(B, false);
+    c.setCore(1);
+    c.access(A, false);         // 14, then 10
+    c.access(B, false);
+    c.access(B, false);         // L1 hit: not charged
+
+    const Histogram &h0 = c.getL2HitLatencies(0);
+    const Histogram &h1 = c.getL2HitLatencies(1);
+    assert(h0.getCount() == 2 and h0.getSum() == 24 and h0.getMax() == 14);
+    assert(h1.getCount() == 2 and h1.getSum() == 24);
+
+    // moving core 1 next to bank 0 only changes its later hits
+    c.setL2BankPosition(3, 0, 0);
+    c.access(A, false);         // 10 + 2 * 2
+    c.access(B, false);         // 10 + 2 * 2
+    assert(&c.getL2HitLatencies(1) == &h1);
+    assert(h1.getCount() == 4 and h1.getSum() == 24 + 28);
+    c.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test23() {
+    printf("Running %s...\n", __func__);
+
+    // 2-cycle hits, 100-cycle memory
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    auto c = LRUSimpleCache(4, 4, 1, 64, false);
+    c.setLatencies(2, 100);
+    std::vector<uintptr_t> addrs = { 0, 64, 128, 192, 0, 64, 128, 192 };
+    std::vector<uint8_t> isWrites = { 0, 1, 0, 1, 0, 1, 0, 1 };
+    c.accessBatch(addrs.data(), isWrites.data(), addrs.size());
+    c.computeStats();
+    SimpleCache::stats_t *s = c.getStats();
+    assert(s->totalCycles == 4 * 2 + 4 * 102 and s->stallCycles == 400);
+    assert(s->AMAT == 52.0);
+    assert(c.getAccessLatencies().percentile(50) == 2);
+    assert(c.getAccessLatencies().getMax() == 102);
+
+    // 1-cycle L1, +10-cycle L2, +100-cycle memory
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache two(1, 1, 64, 4, 1, 64);
+    two.setLatencies(1, 10, 100);
+    addrs = { 0, 64, 0, 0 };    // miss, miss, L2 hit, L1 hit
+    isWrites = { 0, 0, 1, 0 };
+    two.accessBatch(addrs.data(), isWrites.data(), addrs.size());
+    two.computeStats();
+    assert(two.getStats()->totalCycles == 111 + 111 + 11 + 1);
+    assert(two.getStats()->stallCycles == 234 - 4);
+    assert(two.getStats()->AMAT == 58.5);
+
+    // with NUCA deciding the L2 part: banks at (0,0) and (1,0)
+    LRUCache nuca(1, 1, 64, 4, 2, 64, BANK_HASH_PAGE_INTERLEAVED);
+    nuca.enableNUCA(2, 1, 10, 2);
+    nuca.setLatencies(1, 0, 100);
+    addrs = { 0, 4096, 0, 4096 };
+    nuca.accessBatch(addrs.data(), isWrites.data(), addrs.size());
+    nuca.computeStats();
+    assert(nuca.getStats()->totalCycles == 111 + 113 + 11 + 13);
+    assert(nuca.getAccessLatencies().getCount() == 4);
+    nuca.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test24() {
+    printf("Running %s...\n", __func__);
+
+    // 1-cycle L1, +10 L2, +100 memory; 2 MSHRs per level; issue every cycle
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache c(4, 4, 64, 4, 1, 64);
+    c.setLatencies(1, 10, 100);
+    c.enableMSHRs(2, 2);
+
+    c.access(0, false);         // @0: primary; memory at 11, done at 111
+    c.access(8, false);         // @1: secondary, done at 111
+    c.access(64, false);        // @2: primary, done at 113
+    c.access(128, false);       // @3: L1 MSHRs full until 111; done at 222
+    c.access(136, false);       // @112: secondary, done at 222
+    c.computeStats();
+
+    Cache::stats_t *s = c.getStats();
+    assert(s->memRequests == 3 and s->L2RM == 3);
+    assert(s->L1SecondaryMisses == 2 and s->L2SecondaryMisses == 0);
+    assert(s->elapsedCycles == 222);
+    assert(s->totalCycles == 111 + 110 + 111 + 219 + 110);
+    assert(c.getAccessLatencies().getMax() == 219);
+    c.dumpTextStats(stderr);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test25() {
+    printf("Running %s...\n", __func__);
+
+    // every access to one bank, one per cycle, 4 cycles each: they queue
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    LRUSimpleCache c(64, 4, 2, 64, false);
+    c.enableBankQueueing(4);
+    for (int i = 0; i < 4; ++i) c.access(0, false);     // waits 0, 3, 6, 9
+    c.access(0, false, 100);                            // long after: idle
+    c.computeStats();
+
+    const BankQueues &q = *c.getBankQueues();
+    assert(c.getStats()->bankConflicts == 3);
+    assert(c.getStats()->bankQueueingCycles == 18);
+    assert(q.getNConflicts(0) == 3 and q.getNConflicts(1) == 0);
+    assert(q.getQueueingDelays(0).getMax() == 9);
+    assert(q.getUtilization(0) == 20.0 / 104.0);
+    assert(q.getUtilization(1) == 0.0);
+    c.dumpTextStats(stderr);
+
+    // alternating banks, each done before its next access: no conflicts
+    LRUSimpleCache d(64, 4, 2, 64, false);
+    d.enableBankQueueing(2);
+    for (int i = 0; i < 8; ++i) d.access((i % 2) * 64, false);
+    d.computeStats();
+    assert(d.getStats()->bankConflicts == 0);
+    assert(d.getBankQueues()->getUtilization(0) == 8.0 / 9.0);
+
+    // L2 banks only see L1 misses, and a blocking miss waits out its queue
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache e(4, 4, 64, 4, 2, 64);
+    e.setLatencies(1, 10, 100);
+    e.enableL2BankQueueing(4);
+    e.access(0, false);         // bank 0, @0
+    e.access(0, false);         // L1 hit: no L2 access
+    e.access(64, false);        // bank 1, @2
+    e.access(128, false);       // bank 0, @3: waits 1
+    e.computeStats();
+    assert(e.getStats()->L2BankConflicts == 1);
+    assert(e.getStats()->L2BankQueueingCycles == 1);
+    assert(e.getStats()->totalCycles == 3 * 111 + 1 + 1);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test26() {
+    printf("Running %s...\n", __func__);
+
+    // 1 channel, 2 banks, 4-line rows: lines 0-3 are bank 0's row 0, lines
+    // 4-7 bank 1's row 0, and lines 8-11 bank 0's row 1
+    dram_config_t config = DRAM::defaultConfig();
+    config.nChannels = 1;
+    config.nRanksPerChannel = 1;
+    config.nBanksPerRank = 2;
+    config.rowNBytes = 256;
+    config.tCAS = config.tRCD = config.tRP = 10;
+    config.tBurst = 2;
+    config.queueDepth = 4;
+
+    // FR-FCFS serves line 1 (an open-row hit) ahead of the older line 8
+    DRAM open(config);
+    open.request(0, false, 0);      // activate, done at 22
+    open.request(8, false, 0);      // row conflict, after line 1: done at 46
+    open.request(1, false, 0);      // row hit, done at 24
+    open.flush();
+    DRAM::stats_t *s = open.getStats();
+    assert(s->nReads == 3 and s->nWrites == 0);
+    assert(s->nRowHits == 1 and s->nRowMisses == 1 and s->nRowConflicts == 1);
+    assert(s->nBankBusyWaits == 2);
+    assert(open.getLatencies().getSum() == 22 + 24 + 46);
+    assert(s->busUtilization == 6.0 / 46.0);
+    open.dumpTextStats(stderr);
+
+    // closed-page: every access activates, so no hits (and no conflicts)
+    config.pagePolicy = DRAM_CLOSED_PAGE;
+    DRAM closed(config);
+    closed.request(0, false, 0);
+    closed.request(8, false, 0);
+    closed.request(1, false, 0);
+    closed.flush();
+    s = closed.getStats();
+    assert(s->nRowHits == 0 and s->nRowMisses == 3);
+    assert(closed.getLatencies().getMax() == 86);
+
+    // behind a cache: misses are reads, dirty evictions are writes
+    DRAM mem(DRAM::defaultConfig());
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+    LRUSimpleCache c(4, 4, 1, 64, false);
+    c.attachDRAM(&mem);
+    for (int i = 0; i < 4; ++i) c.access(i * 64, true);
+    c.access(4 * 64, false);        // evicts (dirty) line 0
+    c.access(5 * 64, false);        // evicts line 1
+    c.access(4 * 64, false);        // hit
+    mem.flush();
+    assert(c.getStats()->memReads == 6 and c.getStats()->memWritebacks == 2);
+    assert(mem.getStats()->nReads == 6 and mem.getStats()->nWrites == 2);
+
+    // two levels: only the L2's misses and dirty evictions reach memory
+    DRAM mem2(DRAM::defaultConfig());
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache d(4, 4, 8, 8, 1, 64);
+    d.attachDRAM(&mem2);
+    for (int i = 0; i < 8; ++i) d.access(i * 64, i < 2);
+    d.access(8 * 64, false);        // evicts (dirty) line 0
+    d.access(9 * 64, false);        // evicts line 1 (dirty)
+    d.access(10 * 64, false);       // evicts line 2 (clean)
+    assert(d.getStats()->memReads == 11);
+    assert(d.getStats()->memWritebacks == 2);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test27() {
+    printf("Running %s...\n", __func__);
+
+    const char *path = "/tmp/cachesim_test27.csmt";
+    typedef struct {
+        uint64_t index, line;
+        bool isWriteback;
+    } rec_t;
+
+    // the same stream test26 sent to DRAM
+    {
+        MissTraceWriter trace(path, 64);
+        /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly */
+        LRUSimpleCache c(4, 4, 1, 64, false);
+        c.setMissTrace(&trace);
+        for (int i = 0; i < 4; ++i) c.access(i * 64, true);
+        c.access(4 * 64, false);
+        c.access(5 * 64, false);
+        c.access(4 * 64, false);
+        assert(trace.getNRecords() == 8);
+    }   // closes the trace
+
+    rec_t expected[8] = { { 0, 0, false }, { 1, 1, false }, { 2, 2, false },
+            { 3, 3, false }, { 4, 0, true }, { 4, 4, false }, { 5, 1, true },
+            { 5, 5, false } };
+    MissTraceReader reader(path);
+    assert(reader.getCacheLineNBytes() == 64);
+    rec_t r;
+    for (const rec_t &e : expected) {
+        assert(reader.next(r.index, r.line, r.isWriteback));
+        assert(r.index == e.index and r.line == e.line);
+        assert(r.isWriteback == e.isWriteback);
+    }
+    assert(!reader.next(r.index, r.line, r.isWriteback));
+
+    // a long L2 stream through a tiny buffer, so the writer thread is busy
+    size_t nBytes;
+    {
+        MissTraceWriter trace(path, 64, 64);
+        /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+        LRUCache d(4, 4, 64, 4, 1, 64);
+        d.setMissTrace(&trace);
+        for (uint64_t i = 0; i < 100000; ++i) {
+            d.access((i % 1000) * 64, i % 3 == 0);
+        }
+        d.computeStats();
+        size_t n = d.getStats()->memReads + d.getStats()->memWritebacks;
+        assert(trace.getNRecords() == n);
+        trace.close();
+        nBytes = trace.getNBytes();
+    }
+
+    MissTraceReader reader2(path);
+    size_t nRecords = 0;
+    uint64_t lastIndex = 0;
+    while (reader2.next(r.index, r.line, r.isWriteback)) {
+        assert(r.index >= lastIndex and r.line < 1000);
+        lastIndex = r.index;
+        ++nRecords;
+    }
+    assert(nRecords > 100000 and lastIndex == 99999);
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    assert(size_t(in.tellg()) == nBytes);
+    assert(nBytes < nRecords * 4);
+    remove(path);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test28() {
+    printf("Running %s...\n", __func__);
+
+    // word-granularity sweeps over a few arrays, with random stragglers
+    std::vector<uintptr_t> addrs;
+    std::vector<uint8_t> isWrites;
+    srand(28);
+    for (int pass = 0; pass < 4; ++pass) {
+        for (uintptr_t a = 0; a < 64 * 1024; a += 8) {
+            addrs.push_back(0x100000 + a);
+            isWrites.push_back(pass % 2);
+            if (rand() % 16 == 0) {
+                addrs.push_back(0x900000 + (rand() % 4096) * 8);
+                isWrites.push_back(rand() % 2);
+            }
+        }
+    }
+    size_t n = addrs.size();
+    uint64_t hash = L1Filter::hashTrace(addrs.data(), isWrites.data(), n);
+    remove(L1Filter(64, 4, 64).cachePath("/tmp", hash).c_str());
+    remove(L1Filter(128, 4, 64).cachePath("/tmp", hash).c_str());
+
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache full(64, 4, 512, 8, 4, 64);
+    full.enableMissClassification();
+    full.setLatencies(4, 12, 200);
+    DRAM fullMem(DRAM::defaultConfig());
+    full.attachDRAM(&fullMem);
+    full.accessBatch(addrs.data(), isWrites.data(), n);
+    full.computeStats();
+
+    // the first sweep point filters and saves; the second just loads
+    L1Filter filter(64, 4, 64);
+    assert(!filter.loadOrFilter("/tmp", addrs.data(), isWrites.data(), n));
+    L1Filter reloaded(64, 4, 64);
+    assert(reloaded.loadOrFilter("/tmp", addrs.data(), isWrites.data(), n));
+    assert(reloaded.getNAccesses() == n);
+    assert(reloaded.getRuns().size() == filter.getRuns().size());
+    assert(filter.getRuns().size() * 4 < n);
+
+    LRUCache replayed(64, 4, 512, 8, 4, 64);
+    replayed.enableMissClassification();
+    replayed.setLatencies(4, 12, 200);
+    DRAM replayedMem(DRAM::defaultConfig());
+    replayed.attachDRAM(&replayedMem);
+    replayed.replayL1Filtered(reloaded);
+    replayed.computeStats();
+
+    Cache::stats_t &a = *full.getStats(), &b = *replayed.getStats();
+    assert(a.L1RH == b.L1RH and a.L2RH == b.L2RH and a.L2RM == b.L2RM);
+    assert(a.L1WH == b.L1WH and a.L2WH == b.L2WH and a.L2WM == b.L2WM);
+    assert(a.L2BankImbalance == b.L2BankImbalance);
+    assert(full.getL2BankAccesses() == replayed.getL2BankAccesses());
+    assert(memcmp(a.L2RMByClass, b.L2RMByClass, sizeof(a.L2RMByClass)) == 0);
+    assert(memcmp(a.L2WMByClass, b.L2WMByClass, sizeof(a.L2WMByClass)) == 0);
+    assert(a.totalCycles == b.totalCycles and a.AMAT == b.AMAT);
+    assert(a.memReads == b.memReads and a.memWritebacks == b.memWritebacks);
+    assert(a.memWritebacks > 0);
+
+    // a different L1 is a different stream
+    L1Filter other(128, 4, 64);
+    assert(!other.loadOrFilter("/tmp", addrs.data(), isWrites.data(), n));
+
+    remove(filter.cachePath("/tmp", hash).c_str());
+    remove(other.cachePath("/tmp", hash).c_str());
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test29() {
+    printf("Running %s...\n", __func__);
+
+    std::vector<uintptr_t> addrs;
+    std::vector<uint8_t> isWrites;
+    srand(29);
+    for (size_t i = 0; i < 400000; ++i) {
+        addrs.push_back(rand() % 2 ? (i * 8) % (1 << 20) : rand() % (1 << 22));
+        isWrites.push_back(rand() % 4 == 0);
+    }
+    size_t n = addrs.size();
+
+    /* L1NLines, L1NWays, L2NLines, L2NWays, L2NBanks, cacheLineNBytes */
+    LRUCache serial(64, 4, 2048, 8, 4, 64);
+    LRUCache pipelined(64, 4, 2048, 8, 4, 64);
+    for (LRUCache *c : { &serial, &pipelined }) {
+        c->enableMissClassification();
+        c->setLatencies(4, 12, 200);
+        c->enableMSHRs(8, 16);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    serial.accessBatch(addrs.data(), isWrites.data(), n);
+    auto mid = std::chrono::steady_clock::now();
+    pipelined.accessBatchPipelined(addrs.data(), isWrites.data(), n, 256);
+    auto end = std::chrono::steady_clock::now();
+    printf("serial: %.1f ms    pipelined: %.1f ms\n",
+            std::chrono::duration<double, std::milli>(mid - start).count(),
+            std::chrono::duration<double, std::milli>(end - mid).count());
+
+    serial.computeStats();
+    pipelined.computeStats();
+    Cache::stats_t &a = *serial.getStats(), &b = *pipelined.getStats();
+    assert(a.L1RH == b.L1RH and a.L2RH == b.L2RH and a.L2RM == b.L2RM);
+    assert(a.L1WH == b.L1WH and a.L2WH == b.L2WH and a.L2WM == b.L2WM);
+    assert(serial.getL2BankAccesses() == pipelined.getL2BankAccesses());
+    assert(memcmp(a.L2RMByClass, b.L2RMByClass, sizeof(a.L2RMByClass)) == 0);
+    assert(a.totalCycles == b.totalCycles and a.AMAT == b.AMAT);
+    assert(a.elapsedCycles == b.elapsedCycles);
+    assert(a.L1SecondaryMisses == b.L1SecondaryMisses);
+
+    // and the pipeline picks up where serial accesses left off
+    pipelined.access(0, true);
+    serial.access(0, true);
+    pipelined.accessBatchPipelined(addrs.data(), isWrites.data(), 1000);
+    serial.accessBatch(addrs.data(), isWrites.data(), 1000);
+    serial.computeStats();
+    pipelined.computeStats();
+    assert(a.L1RH == b.L1RH and a.L2RM == b.L2RM and a.L1WH == b.L1WH);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test30() {
+    printf("Running %s...\n", __func__);
+
+    std::vector<uintptr_t> addrs;
+    std::vector<uint8_t> isWrites;
+    srand(30);
+    for (size_t i = 0; i < 200000; ++i) {
+        addrs.push_back(rand() % 2 ? (i * 8) % (1 << 18) : rand() % (1 << 20));
+        isWrites.push_back(rand() % 4 == 0);
+    }
+    size_t n = addrs.size();
+
+    WorkStealingPool pool(4);
+    // set-associative maps, and the flat engine for wide sets
+    for (size_t nWays : { size_t(8), size_t(128) }) {
+        LRUSimpleCache serial(1024, nWays, 2, 64, false);
+        LRUSimpleCache parallel(1024, nWays, 2, 64, false);
+        serial.accessBatch(addrs.data(), isWrites.data(), n);
+        parallel.accessBatchParallel(addrs.data(), isWrites.data(), n, pool,
+                8);
+
+        serial.computeStats();
+        parallel.computeStats();
+        SimpleCache::stats_t &a = *serial.getStats();
+        SimpleCache::stats_t &b = *parallel.getStats();
+        assert(a.RH == b.RH and a.RM == b.RM and a.nE == b.nE);
+        assert(a.WH == b.WH and a.WM == b.WM);
+        assert(serial.getBankAccesses() == parallel.getBankAccesses());
+
+        // and ends up holding the same lines, in the same LRU order
+        for (size_t i = 0; i < 1000; ++i) {
+            serial.access(addrs[n - 1 - i] + 4096, false);
+            parallel.access(addrs[n - 1 - i] + 4096, false);
+        }
+        serial.computeStats();
+        parallel.computeStats();
+        assert(a.RH == b.RH and a.nE == b.nE);
+    }
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test31() {
+    printf("Running %s...\n", __func__);
+
+    std::vector<uintptr_t> addrs;
+    srand(31);
+    for (size_t i = 0; i < 300000; ++i) {
+        // enough distinct lines to make the stacks compact a few times
+        addrs.push_back(rand() % 2 ? (i * 8) % (1 << 18) : rand() % (1 << 24));
+    }
+    size_t n = addrs.size();
+
+    StackDistance serial;
+    serial.accessBatch(addrs.data(), n);
+    assert(serial.getNAccesses() == n);
+
+    // a fully-associative LRU cache misses exactly on distances >= its size
+    for (size_t nLines : { size_t(256), size_t(4096) }) {
+        LRUSimpleCache fa(nLines, nLines, 1, 64, false);
+        std::vector<uint8_t> isWrites(n, 0);
+        fa.accessBatch(addrs.data(), isWrites.data(), n);
+        fa.computeStats();
+        assert(serial.missesAtCapacity(nLines) == fa.getStats()->RM);
+    }
+
+    WorkStealingPool pool(4);
+    for (size_t nChunks : { 2, 7, 64 }) {
+        StackDistance parallel;
+        parallel.accessBatch(addrs.data(), 1000);
+        parallel.accessBatchParallel(addrs.data() + 1000, n - 1000, pool,
+                nChunks);
+        assert(parallel.getDistances() == serial.getDistances());
+        assert(parallel.getNColdMisses() == serial.getNColdMisses());
+        assert(parallel.getNAccesses() == n);
+        assert(parallel.getNDistinctLines() == serial.getNDistinctLines());
+    }
+    serial.dumpTextStats(stdout);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test32() {
+    printf("Running %s...\n", __func__);
+
+    const size_t nTraces = 5;
+    std::atomic<size_t> nLoads(0);
+    auto makeTrace = [](size_t t, std::vector<uintptr_t> &addrs,
+            std::vector<uint8_t> &isWrites) {
+        // loaders run concurrently, so no rand()
+        uint64_t x = 32 + t;
+        for (size_t i = 0; i < 20000; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            addrs.push_back((x >> 20) % ((1 << 14) << t));
+            isWrites.push_back((x >> 50) % 3 == 0);
+        }
+    };
+
+    SweepScheduler sweep(2);
+    for (size_t t = 0; t < nTraces; ++t) {
+        std::string name = "trace" + std::to_string(t);
+        sweep.addTrace(name.c_str(), [t, &nLoads, &makeTrace](
+                std::vector<uintptr_t> &addrs, std::vector<uint8_t> &isWrites) {
+            nLoads.fetch_add(1);
+            makeTrace(t, addrs, isWrites);
+        });
+    }
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly, hash */
+    std::vector<sweep_config_t> configs = {
+        { 64, 4, 1, 64, false, BANK_HASH_FOLD },
+        { 256, 8, 4, 64, false, BANK_HASH_MULTIPLICATIVE },
+        { 256, 128, 2, 64, false, BANK_HASH_FOLD },
+        { 128, 4, 1, 32, true, BANK_HASH_FOLD },
+    };
+    for (size_t c = 0; c < configs.size(); ++c) {
+        sweep.addConfig(("config" + std::to_string(c)).c_str(), configs[c]);
+    }
+
+    WorkStealingPool pool(4);
+    sweep.run(pool);
+    assert(nLoads == nTraces);
+    assert(sweep.getPeakResidentTraces() <= 2);
+
+    // same as simulating each pair on its own
+    for (size_t t = 0; t < nTraces; ++t) {
+        std::vector<uintptr_t> addrs;
+        std::vector<uint8_t> isWrites;
+        makeTrace(t, addrs, isWrites);
+        for (size_t c = 0; c < configs.size(); ++c) {
+            const sweep_config_t &k = configs[c];
+            LRUSimpleCache cache(k.nLines, k.nWays, k.nBanks,
+                    k.cacheLineNBytes, k.allocateOnWritesOnly, k.bankHash);
+            cache.accessBatch(addrs.data(), isWrites.data(), addrs.size());
+            cache.computeStats();
+            const SimpleCache::stats_t &a = *cache.getStats();
+            const SimpleCache::stats_t &b = sweep.getResult(t, c);
+            assert(a.RH == b.RH and a.RM == b.RM and a.nE == b.nE);
+            assert(a.WH == b.WH and a.WM == b.WM);
+        }
+    }
+
+    // one header, then one line per job
+    const char *path = "/tmp/cachesim_test32.tsv";
+    sweep.dumpTextResults(path);
+    std::ifstream in(path);
+    std::string line;
+    size_t nLines = 0;
+    while (std::getline(in, line)) ++nLines;
+    assert(nLines == 1 + nTraces * configs.size());
+    remove(path);
+
+    printf("%s complete.\n", __func__);
+}
+
+
+void test33() {
+    printf("Running %s...\n", __func__);
+
+    std::vector<uintptr_t> addrs;
+    std::vector<uint8_t> isWrites;
+    srand(33);
+    for (size_t i = 0; i < 20000; ++i) {
+        addrs.push_back(rand() % (1 << 16));
+        isWrites.push_back(rand() % 3 == 0);
+    }
+    uint64_t traceHash = L1Filter::hashTrace(addrs.data(), isWrites.data(),
+            addrs.size());
+
+    /* nLines, nWays, nBanks, cacheLineNBytes, allocateOnWritesOnly, hash */
+    std::vector<sweep_config_t> configs = {
+        { 64, 4, 1, 64, false, BANK_HASH_FOLD },
+        { 256, 8, 4, 64, false, BANK_HASH_FOLD },
+        { 256, 8, 4, 64, false, BANK_HASH_CRC32C },
+    };
+    ResultStore store("/tmp");
+    // each parameter is part of the key
+    assert(ResultStore::hashConfig(configs[1]) !=
+            ResultStore::hashConfig(configs[2]));
+    for (const sweep_config_t &config : configs) {
+        remove(store.path(traceHash, ResultStore::hashConfig(config)).c_str());
+    }
+
+    size_t nLoads = 0;
+    auto sweep = [&](SweepScheduler &s) {
+        s.addTrace("trace", [&](std::vector<uintptr_t> &a,
+                std::vector<uint8_t> &w) {
+            ++nLoads;
+            a = addrs;
+            w = isWrites;
+        });
+        for (const sweep_config_t &config : configs) s.addConfig("c", config);
+        s.setResultStore(&store);
+        WorkStealingPool pool(2);
+        s.run(pool);
+    };
+
+    // first run simulates and saves everything, the second only looks up
+    SweepScheduler first, second;
+    sweep(first);
+    assert(store.getNHits() == 0 and store.getNMisses() == configs.size());
+    sweep(second);
+    assert(store.getNHits() == configs.size() and nLoads == 2);
+    for (size_t c = 0; c < configs.size(); ++c) {
+        const SimpleCache::stats_t &a = first.getResult(0, c);
+        const SimpleCache::stats_t &b = second.getResult(0, c);
+        assert(a.RH == b.RH and a.RM == b.RM and a.WH == b.WH);
+        assert(a.WM == b.WM and a.nE == b.nE and b.computedFinalStats);
+    }
+
+    // two-level results and their text dumps round-trip too
+    LRUCache cache(64, 4, 1024, 8, 2, 64);
+    cache.accessBatch(addrs.data(), isWrites.data(), addrs.size());
+    cache.computeStats();
+    uint64_t configHash = ResultStore::hashLRUCacheConfig(64, 4, 1024, 8, 2,
+            64, BANK_HASH_FOLD);
+    assert(configHash != ResultStore::hashConfig(configs[0]));
+    store.store(traceHash, configHash, cache, "dump text\n");
+
+    LRUCache loaded(64, 4, 1024, 8, 2, 64);
+    std::string dump;
+    assert(store.lookup(traceHash, configHash, loaded, &dump));
+    assert(loaded.getStats()->L2RM == cache.getStats()->L2RM);
+    assert(dump == "dump text\n");
+    // a different trace misses
+    assert(!store.lookup(traceHash + 1, configHash, loaded));
+    // as does a different stats_t kind stored under the same key
+    LRUSimpleCache wrongKind(64, 4, 1, 64, false);
+    assert(!store.lookup(traceHash, configHash, wrongKind));
+    // the key only describes plain caches, so others can't use the store
+    LRUCache timed(64, 4, 1024, 8, 2, 64);
+    assert(!timed.hasOptionalModels());
+    timed.setLatencies(1, 10, 100);
+    assert(timed.hasOptionalModels());
+    wrongKind.enableMissClassification();
+    assert(wrongKind.hasOptionalModels());
+    // as does one saved by a simulator with a different RESULTS_VERSION
+    {
+        std::fstream f(store.path(traceHash, configHash),
+                std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t otherVersion = ResultStore::RESULTS_VERSION + 1;
+        f.seekp(8);
+        f.write((char *)&otherVersion, sizeof(otherVersion));
+    }
+    assert(!store.lookup(traceHash, configHash, loaded));
+
+    remove(store.path(traceHash, configHash).c_str());
+    for (const sweep_config_t &config : configs) {
+        remove(store.path(traceHash, ResultStore::hashConfig(config)).c_str());
+    }
+
+    printf("%s complete.\n", __func__);
+}
+
+
 int main(int argc, char *argv[]) {
     std::cout << "Cachesim test suite" << std::endl;
 
@@ -243,5 +1893,79 @@ int main(int argc, char *argv[]) {
     test5();
     test6();
 
+    // bank hashing
+    test7();
+    test8();
+
+    #ifdef CACHESIM_SET_STATS
+    test9();
+    #endif
+
+    // fully-associative LRU + 3C miss classification
+    test10();
+    test11();
+
+    // first-touch/footprint bitmap
+    test12();
+
+    // fully-associative engine
+    test13();
+
+    // Network topologies + counters
+    test14();
+    test15();
+    test16();
+
+    // cross-rank aggregation
+    test17();
+
+    // network timing model
+    test18();
+
+    // remote-home traffic
+    test19();
+
+    // directory coherence
+    test20();
+
+    // in-process multi-rank simulation
+    test21();
+
+    // NUCA L2 latency
+    test22();
+
+    // timing model
+    test23();
+
+    // MSHRs
+    test24();
+
+    // bank queueing
+    test25();
+
+    // DRAM
+    test26();
+
+    // miss traces
+    test27();
+
+    // memoized L1 filter
+    test28();
+
+    // pipelined L1/L2
+    test29();
+
+    // parallel chunked simulation
+    test30();
+
+    // stack distances
+    test31();
+
+    // trace x configuration sweeps
+    test32();
+
+    // result memoization
+    test33();
+
     return 0;
 }